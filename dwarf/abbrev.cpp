@@ -0,0 +1,180 @@
+/* abbrev.cpp - (c) James S Renwick 2020 */
+#include "abbrev.hpp"
+#include "dwarf.hpp"
+
+namespace dwarf
+{
+	extern std::size_t readHeader(const std::uint8_t* buffer, std::size_t length,
+		std::uint64_t& id_out, std::uint32_t& type_out);
+
+
+    std::uint8_t AbbreviationTable::formSize(AttributeForm form, std::uint8_t addressSize,
+        std::uint8_t offsetSize) noexcept
+    {
+        switch (form)
+        {
+            case AttributeForm::Address:     return addressSize;
+            case AttributeForm::Data1:
+            case AttributeForm::Ref1:
+            case AttributeForm::Flag:        return 1;
+            case AttributeForm::Data2:
+            case AttributeForm::Ref2:        return 2;
+            case AttributeForm::Data4:
+            case AttributeForm::Ref4:        return 4;
+            case AttributeForm::Data8:
+            case AttributeForm::Ref8:
+            case AttributeForm::RefSig8:     return 8;
+            case AttributeForm::Strx1:
+            case AttributeForm::Addrx1:      return 1;
+            case AttributeForm::Strx2:
+            case AttributeForm::Addrx2:      return 2;
+            case AttributeForm::Strx3:
+            case AttributeForm::Addrx3:      return 3;
+            case AttributeForm::Strx4:
+            case AttributeForm::Addrx4:
+            case AttributeForm::RefSup4:     return 4;
+            case AttributeForm::RefSup8:     return 8;
+            case AttributeForm::Data16:      return 16;
+            case AttributeForm::FlagPresent:
+            case AttributeForm::ImplicitConst: return 0;
+            case AttributeForm::SecOffset:
+            case AttributeForm::Strp:
+            case AttributeForm::LineStrp:
+            case AttributeForm::StrpSup:
+            case AttributeForm::RefAddr:     return offsetSize;
+            default: return AbbreviationAttribute::variableSize;
+        }
+    }
+
+
+    error_t AbbreviationTable::parse(const std::uint8_t* section, std::size_t sectionSize,
+        std::uint64_t offset, std::uint8_t addressSize, std::uint8_t offsetSize, AbbreviationTable& table_out)
+    {
+        table_out = AbbreviationTable{};
+        table_out._offset = offset;
+        if (offset >= sectionSize) return -1;
+
+        const std::uint8_t* buffer = section + offset;
+        std::size_t length = sectionSize - offset;
+
+        // Attribute ranges are recorded as indices until all attributes are stored
+        std::vector<Abbreviation> abbreviations;
+        std::vector<std::size_t> firstAttributes;
+        std::uint64_t maxCode = 0;
+
+        while (length != 0)
+        {
+            // Read header, terminating upon null entry
+            Abbreviation abbrev;
+            std::uint32_t tag;
+            auto size = readHeader(buffer, length, abbrev.code, tag);
+            buffer += size; length -= size;
+            if (abbrev.code == 0) break;
+
+            if (length == 0) return -1;
+            abbrev.tag = static_cast<DIEType>(tag);
+            abbrev.hasChildren = *(buffer++) != 0; length--;
+
+            // Compile attributes
+            firstAttributes.push_back(table_out.attributes.size());
+            while (true)
+            {
+                AbbreviationAttribute attr;
+                auto size = AttributeSpecification::parse(buffer, length, attr);
+                if (size == 0 || size > length) return -1;
+
+                buffer += size; length -= size;
+                if (attr.name == AttributeName::None && attr.form == AttributeForm::None) break;
+
+                // Implicit constants are stored in the declaration itself
+                if (attr.form == AttributeForm::ImplicitConst)
+                {
+                    size = sleb_read(buffer, length, attr.implicitConst);
+                    if (size == 0 || size > length) return -1;
+                    buffer += size; length -= size;
+                }
+
+                attr.size = formSize(attr.form, addressSize, offsetSize);
+                attr.fixedOffset = abbrev.fixedSize;
+
+                // Sum fixed sizes, recording slots which must be decoded
+                if (attr.isFixedSize()) abbrev.fixedSize += attr.size;
+                else
+                {
+                    if (abbrev.attributeCount < 64) abbrev.variableMask |= std::uint64_t(1) << abbrev.attributeCount;
+                    abbrev.variableCount++;
+                }
+                if (attr.name == AttributeName::Name && abbrev.nameAttribute == Abbreviation::noAttribute) {
+                    abbrev.nameAttribute = abbrev.attributeCount;
+                }
+                if (attr.name == AttributeName::Sibling && abbrev.siblingAttribute == Abbreviation::noAttribute) {
+                    abbrev.siblingAttribute = abbrev.attributeCount;
+                }
+                table_out.attributes.push_back(attr);
+                abbrev.attributeCount++;
+            }
+
+            if (abbrev.code > maxCode) maxCode = abbrev.code;
+            abbreviations.push_back(abbrev);
+        }
+
+        // Index codes directly up to a bound proportional to the table size
+        std::uint64_t denseLimit = 2 * abbreviations.size() + 16;
+        table_out.dense.resize(maxCode < denseLimit ? maxCode : denseLimit);
+        table_out._size = abbreviations.size();
+
+        for (std::size_t i = 0; i < abbreviations.size(); i++)
+        {
+            // Point abbreviations at their attributes now storage is final
+            auto& abbrev = abbreviations[i];
+            abbrev.attributes = table_out.attributes.data() + firstAttributes[i];
+
+            // Reject duplicate codes
+            if (table_out.find(abbrev.code) != nullptr) return -1;
+
+            if (abbrev.code <= table_out.dense.size()) table_out.dense[abbrev.code - 1] = abbrev;
+            else table_out.sparse.emplace(abbrev.code, abbrev);
+        }
+        return 0;
+    }
+
+
+    error_t AbbreviationCache::get(const std::uint8_t* section, std::size_t sectionSize,
+        std::uint64_t offset, std::uint8_t addressSize, std::uint8_t offsetSize,
+        const AbbreviationTable*& table_out)
+    {
+        // Tables are compiled per address/offset size, which almost all units share
+        std::uint64_t key = (offset << 8) | (std::uint64_t(addressSize & 0xF) << 4) | (offsetSize & 0xF);
+
+        Entry* entry;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto& slot = entries[key];
+            if (!slot) slot.reset(new Entry());
+            entry = slot.get();
+        }
+        // Parse outside the lock; other users of the same table wait for the first
+        std::call_once(entry->once, [&]() {
+            entry->result = AbbreviationTable::parse(section, sectionSize, offset,
+                addressSize, offsetSize, entry->table);
+        });
+
+        // A table that failed to parse may be partly filled in, so is never handed out
+        table_out = entry->result == 0 ? &entry->table : nullptr;
+        return entry->result;
+    }
+
+
+    std::size_t AbbreviationCache::size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+
+
+    void AbbreviationCache::clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.clear();
+    }
+}
@@ -0,0 +1,168 @@
+/* abbrev.hpp - (c) James S Renwick 2020 */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "const.hpp"
+#include "format.hpp"
+
+namespace dwarf
+{
+    typedef signed long int error_t;
+
+
+    /* An attribute specification of a compiled abbreviation, with the size of its value
+       where that is fixed for the units using the table. */
+    struct AbbreviationAttribute : public AttributeSpecification
+    {
+        static constexpr std::uint8_t variableSize = 0xFF;
+
+        std::uint8_t size{}; // Size of the value in bytes, or variableSize
+
+        // Total size of the fixed-size values preceding this one in the abbreviation
+        std::uint32_t fixedOffset{};
+
+        // The value of a DW_FORM_implicit_const attribute, held by the abbreviation
+        // rather than by the DIE
+        std::int64_t implicitConst{};
+
+    public:
+        inline bool isFixedSize() const noexcept {
+            return size != variableSize;
+        }
+    };
+
+
+    /* An abbreviation declaration compiled into a flat descriptor, so DIEs can be walked
+       without re-decoding the declaration. */
+    struct Abbreviation
+    {
+        static constexpr std::uint32_t noAttribute = static_cast<std::uint32_t>(-1);
+
+        std::uint64_t code{};
+        DIEType tag{};
+        bool hasChildren{};
+
+        // Attribute specifications, held contiguously by the owning table
+        std::uint32_t attributeCount{};
+        const AbbreviationAttribute* attributes{};
+
+        // Total size of the fixed-size values, and the slots of the variable-size values
+        // (bit i for attribute i, for the first 64 attributes)
+        std::uint32_t fixedSize{};
+        std::uint32_t variableCount{};
+        std::uint64_t variableMask{};
+
+        // Slots of the DW_AT_name and DW_AT_sibling attributes, or noAttribute
+        std::uint32_t nameAttribute = noAttribute;
+        std::uint32_t siblingAttribute = noAttribute;
+
+    public:
+        /* Whether every value is fixed-size, so the DIE's values span exactly fixedSize bytes. */
+        inline bool isFixedSize() const noexcept {
+            return variableCount == 0;
+        }
+        /* Whether variableMask accounts for every variable-size value. */
+        inline bool hasCompleteMask() const noexcept {
+            return variableCount == static_cast<std::uint32_t>(__builtin_popcountll(variableMask));
+        }
+
+        inline const AbbreviationAttribute* begin() const noexcept {
+            return attributes;
+        }
+        inline const AbbreviationAttribute* end() const noexcept {
+            return attributes + attributeCount;
+        }
+    };
+
+
+    /* One abbreviation table within .debug_abbrev, compiled for units of a given address
+       and offset size. */
+    class AbbreviationTable
+    {
+    private:
+        std::uint64_t _offset{};
+        std::size_t _size{};
+        std::vector<AbbreviationAttribute> attributes{};
+
+        // Abbreviations indexed by code - 1, with code 0 marking unused codes. Compilers
+        // number abbreviations densely from 1, so this almost always holds the whole table.
+        std::vector<Abbreviation> dense{};
+        // Abbreviations whose codes are too sparse to index directly
+        std::unordered_map<std::uint64_t, Abbreviation> sparse{};
+
+    public:
+        AbbreviationTable() = default;
+
+        // Abbreviations point into the table's attribute storage
+        AbbreviationTable(const AbbreviationTable&) = delete;
+        AbbreviationTable& operator=(const AbbreviationTable&) = delete;
+        AbbreviationTable(AbbreviationTable&&) = default;
+        AbbreviationTable& operator=(AbbreviationTable&&) = default;
+
+    public:
+        /* Gets the size of values of the given form, or AbbreviationAttribute::variableSize
+           if the size depends on the value. */
+        static std::uint8_t formSize(AttributeForm form, std::uint8_t addressSize, std::uint8_t offsetSize) noexcept;
+
+        /* Parses and compiles the table at the given offset into the .debug_abbrev section. */
+        static error_t parse(const std::uint8_t* section, std::size_t sectionSize, std::uint64_t offset,
+            std::uint8_t addressSize, std::uint8_t offsetSize, AbbreviationTable& table_out);
+
+        /* Finds the abbreviation with the given code, or returns nullptr. */
+        inline const Abbreviation* find(std::uint64_t code) const noexcept
+        {
+            // Code 0 wraps around, so is never found in the dense index
+            if (code - 1 < dense.size())
+            {
+                auto* abbrev = &dense[code - 1];
+                return abbrev->code != 0 ? abbrev : nullptr;
+            }
+            if (sparse.empty()) return nullptr;
+
+            auto it = sparse.find(code);
+            return it != sparse.end() ? &it->second : nullptr;
+        }
+
+        inline std::uint64_t offset() const noexcept {
+            return _offset;
+        }
+        inline std::size_t size() const noexcept {
+            return _size;
+        }
+    };
+
+
+    /* The abbreviation tables of a .debug_abbrev section, keyed by offset (and by the address
+       and offset size they were compiled for). Each table is parsed on first use and then
+       shared by every unit referring to it. Safe to use from concurrent indexing threads;
+       tables remain valid until the cache is cleared. */
+    class AbbreviationCache
+    {
+    private:
+        struct Entry
+        {
+            std::once_flag once{};
+            error_t result{};
+            AbbreviationTable table{};
+        };
+
+        mutable std::mutex mutex{};
+        std::unordered_map<std::uint64_t, std::unique_ptr<Entry>> entries{};
+
+    public:
+        /* Gets the table at the given offset into the given .debug_abbrev section,
+           parsing it if not already cached. Returns -1, with 'table_out' set to nullptr,
+           if the table cannot be parsed. */
+        error_t get(const std::uint8_t* section, std::size_t sectionSize, std::uint64_t offset,
+            std::uint8_t addressSize, std::uint8_t offsetSize, const AbbreviationTable*& table_out);
+
+        /* Gets the number of distinct tables cached. */
+        std::size_t size() const;
+
+        void clear();
+    };
+}
@@ -0,0 +1,414 @@
+/* cache.cpp - (c) James S Renwick 2020 */
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "dwarf.hpp"
+
+/*
+   An index cache file holds the DIE index of each unit of a context and, if built, its
+   name index. It is laid out so that it can be used in place once mapped:
+
+       CacheHeader
+       CacheUnit[unitCount]             CU directory
+       per unit: tags, nameSources,     DIE index columns, as in DieColumns
+                 parents, names, offsets,
+                 nextSiblings, subtreeEnds
+       names, slots, ids, tags          Name index arrays, as in NameIndex
+
+   Every array begins on an 8-byte boundary. Files are only valid on hosts of the same
+   byte order and version.
+
+   A file is keyed by build-ID and the layout of the sections it was built from, so that
+   it can be matched without reading them. Loading checks only the header and the bounds
+   of each array; the columns of each unit are checked as the unit is adopted. The
+   checksum, covering everything after the header, and the hash of the sections' contents
+   are only checked on request.
+*/
+
+namespace dwarf
+{
+    static constexpr char cacheMagic[8] = { 'D', 'W', 'I', 'D', 'X', 'C', 'A', 'C' };
+    static constexpr std::uint32_t cacheVersion = 4; // 3: name source column, 4: section layout key
+    static constexpr std::uint32_t cacheByteOrder = 0x01020304;
+    static constexpr std::size_t maxBuildIdSize = 64;
+
+    struct CacheHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byteOrder;
+        std::uint64_t fileSize;
+        std::uint64_t checksum;     // Hash of the file after the header
+        std::uint64_t sectionsHash; // Hash of the contents of the context's sections
+        std::uint64_t sectionsKey;  // Hash of the type, file offset and size of the context's sections
+        std::uint32_t buildIdSize;
+        std::uint32_t unitCount;
+        std::uint8_t  buildId[maxBuildIdSize];
+
+        // Name index, if any
+        std::uint64_t nameCount;
+        std::uint64_t slotCount;
+        std::uint64_t idCount;
+        std::uint64_t namesOffset;
+    };
+
+    struct CacheUnit
+    {
+        std::uint64_t offset;    // Offset of the unit header within .debug_info
+        std::uint64_t endOffset;
+        std::uint64_t entryCount;
+        std::uint64_t columnsOffset;
+        std::uint64_t droppedNames;
+    };
+
+    static_assert(sizeof(CacheHeader) % 8 == 0 && sizeof(CacheUnit) % 8 == 0, "");
+    static_assert(sizeof(DIEType) == 2 && sizeof(NameSource) == 1, "");
+
+
+    static inline std::uint64_t _align(std::uint64_t offset) noexcept {
+        return (offset + 7) & ~std::uint64_t(7);
+    }
+
+    // Gets the size of the DIE index columns of a unit with the given number of DIEs
+    static inline std::uint64_t _columnsSize(std::uint64_t count) noexcept {
+        return _align(count * sizeof(DIEType)) + _align(count * sizeof(NameSource)) +
+            5 * _align(count * sizeof(std::uint32_t));
+    }
+
+
+    // 64-bit hash of the given bytes (MurmurHash3-style), reading a word at a time
+    static std::uint64_t _hashBytes(const std::uint8_t* data, std::size_t size, std::uint64_t seed) noexcept
+    {
+        constexpr std::uint64_t c1 = 0x87c37b91114253d5ull, c2 = 0x4cf5ad432745937full;
+        auto rotl = [](std::uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); };
+        auto mix = [&](std::uint64_t word) { return rotl(word * c1, 31) * c2; };
+
+        std::uint64_t hash = seed ^ (size * c1);
+        for (; size >= 8; data += 8, size -= 8)
+        {
+            std::uint64_t word; std::memcpy(&word, data, 8);
+            hash = rotl(hash ^ mix(word), 27) * 5 + 0x52dce729;
+        }
+        if (size != 0)
+        {
+            std::uint64_t word = 0; std::memcpy(&word, data, size);
+            hash ^= mix(word);
+        }
+
+        // Finalise
+        hash ^= hash >> 33; hash *= 0xff51afd7ed558ccdull;
+        hash ^= hash >> 33; hash *= 0xc4ceb9fe1a85ec53ull;
+        return hash ^ (hash >> 33);
+    }
+
+
+    class IndexCache
+    {
+    public:
+        // Hashes the type and contents of each of the context's sections
+        static std::uint64_t sectionsHash(const DwarfContext& context) noexcept
+        {
+            std::uint64_t hash = 0;
+            for (auto& section : context.sections)
+            {
+                if (!section || section.data.get() == nullptr) continue;
+                hash = _hashBytes(section.data.get(), section.size, hash + static_cast<std::uint64_t>(section.type));
+            }
+            return hash;
+        }
+
+        // Hashes the type, file offset and size of each of the context's sections
+        static std::uint64_t sectionsKey(const DwarfContext& context) noexcept
+        {
+            std::uint64_t hash = 0;
+            for (auto& section : context.sections)
+            {
+                if (!section) continue;
+                std::uint64_t key[3] = { static_cast<std::uint64_t>(section.type), section.fileOffset, section.size };
+                hash = _hashBytes(reinterpret_cast<const std::uint8_t*>(key), sizeof(key), hash);
+            }
+            return hash;
+        }
+
+
+        template<typename T>
+        static void appendArray(std::vector<std::uint8_t>& image, const Column<T>& column)
+        {
+            auto size = column.size() * sizeof(T);
+            auto offset = image.size();
+            image.resize(_align(offset + size));
+            if (size != 0) std::memcpy(image.data() + offset, column.data(), size);
+        }
+
+        template<typename T>
+        static Column<T> borrowArray(const std::uint8_t* file, std::uint64_t& offset, std::uint64_t count)
+        {
+            auto column = Column<T>::borrow(reinterpret_cast<const T*>(file + offset), count);
+            offset = _align(offset + count * sizeof(T));
+            return column;
+        }
+
+
+        static error_t save(const DwarfContext& context, const char* path,
+            const std::uint8_t* buildId, std::size_t buildIdSize)
+        {
+            if (buildIdSize > maxBuildIdSize) return -1;
+
+            CacheHeader header{};
+            std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+            header.version = cacheVersion;
+            header.byteOrder = cacheByteOrder;
+            header.sectionsHash = sectionsHash(context);
+            header.sectionsKey = sectionsKey(context);
+            header.buildIdSize = static_cast<std::uint32_t>(buildIdSize);
+            header.unitCount = static_cast<std::uint32_t>(context.units.size());
+            if (buildIdSize != 0) std::memcpy(header.buildId, buildId, buildIdSize);
+
+            // Lay out the CU directory, then each unit's columns
+            std::vector<std::uint8_t> image(sizeof(CacheHeader) + context.units.size() * sizeof(CacheUnit));
+            for (auto& unit : context.units)
+            {
+                if (context.indexUnit(unit) != 0) return -1;
+
+                auto& entries = unit.entries;
+                CacheUnit record{ unit.offset, unit.endOffset, entries.size(), image.size(), entries.droppedNames };
+                std::memcpy(image.data() + sizeof(CacheHeader) + unit.index * sizeof(CacheUnit), &record, sizeof(record));
+
+                appendArray(image, entries.tags);
+                appendArray(image, entries.nameSources);
+                appendArray(image, entries.parents);
+                appendArray(image, entries.names);
+                appendArray(image, entries.offsets);
+                appendArray(image, entries.nextSiblings);
+                appendArray(image, entries.subtreeEnds);
+            }
+
+            // Append the name index
+            auto& names = context.nameIndex;
+            if (!names.empty())
+            {
+                header.nameCount = names.names.size();
+                header.slotCount = names.slots.size();
+                header.idCount = names.ids.size();
+                header.namesOffset = image.size();
+
+                appendArray(image, names.names);
+                appendArray(image, names.slots);
+                appendArray(image, names.ids);
+                appendArray(image, names.tags);
+            }
+
+            header.fileSize = image.size();
+            header.checksum = _hashBytes(image.data() + sizeof(CacheHeader), image.size() - sizeof(CacheHeader), 0);
+            std::memcpy(image.data(), &header, sizeof(header));
+
+            // Write to a temporary file and move it into place, so readers never see a partial file
+            std::string temporary = std::string(path) + ".tmp" + std::to_string(::getpid());
+            std::FILE* file = std::fopen(temporary.c_str(), "wb");
+            if (file == nullptr) return -1;
+
+            bool written = std::fwrite(image.data(), 1, image.size(), file) == image.size();
+            written = std::fclose(file) == 0 && written;
+
+            if (!written || std::rename(temporary.c_str(), path) != 0)
+            {
+                std::remove(temporary.c_str());
+                return -1;
+            }
+            return 0;
+        }
+
+
+        // Whether a name of the given unit lies within the section it refers to
+        static bool validName(const DwarfContext& context, const CompilationUnit& unit, NameSource source, std::uint32_t offset)
+        {
+            switch (source)
+            {
+                case NameSource::None:    return true;
+                case NameSource::Str:     return offset < context[SectionType::debug_str].size;
+                case NameSource::LineStr: return offset < context[SectionType::debug_line_str].size;
+                case NameSource::Inline:  return offset < unit.endOffset - unit.offset;
+                default:                  return false;
+            }
+        }
+
+        // Checks that every position and offset in a unit's columns is within range. Parents
+        // must precede their children, so the parent links cannot form a cycle.
+        static bool validColumns(const DwarfContext& context, const CompilationUnit& unit,
+            const std::uint8_t* file, const CacheUnit& record)
+        {
+            auto offset = record.columnsOffset;
+            auto count = static_cast<std::uint32_t>(record.entryCount);
+
+            borrowArray<DIEType>(file, offset, count);
+            auto nameSources = borrowArray<NameSource>(file, offset, count);
+            auto parents = borrowArray<std::uint32_t>(file, offset, count);
+            auto names = borrowArray<std::uint32_t>(file, offset, count);
+            auto offsets = borrowArray<std::uint32_t>(file, offset, count);
+            auto nextSiblings = borrowArray<std::uint32_t>(file, offset, count);
+            auto subtreeEnds = borrowArray<std::uint32_t>(file, offset, count);
+
+            for (std::uint32_t i = 0; i < count; i++)
+            {
+                if ((parents[i] != DieColumns::noParent && parents[i] >= i) ||
+                    (nextSiblings[i] != DieColumns::noSibling && (nextSiblings[i] <= i || nextSiblings[i] >= count)) ||
+                    subtreeEnds[i] <= i || subtreeEnds[i] > count ||
+                    offsets[i] < unit.dieOffset - unit.offset || offsets[i] >= unit.endOffset - unit.offset ||
+                    !validName(context, unit, nameSources[i], names[i])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Checks the header, CU directory and layout of a mapped cache file against the context,
+        // and if 'verifyContents' is set, its checksum and the contents of the sections
+        static bool validate(const DwarfContext& context, const std::uint8_t* file, std::size_t size,
+            const std::uint8_t* buildId, std::size_t buildIdSize, bool verifyContents)
+        {
+            CacheHeader header;
+            if (size < sizeof(header)) return false;
+            std::memcpy(&header, file, sizeof(header));
+
+            if (std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 ||
+                header.version != cacheVersion || header.byteOrder != cacheByteOrder ||
+                header.fileSize != size) return false;
+
+            // Check the key
+            if (header.buildIdSize != buildIdSize || buildIdSize > maxBuildIdSize ||
+                (buildIdSize != 0 && std::memcmp(header.buildId, buildId, buildIdSize) != 0)) return false;
+            if (header.unitCount != context.units.size()) return false;
+            if (header.sectionsKey != sectionsKey(context)) return false;
+
+            // Check the CU directory and that each unit's columns are within the file
+            if (header.unitCount > (size - sizeof(CacheHeader)) / sizeof(CacheUnit)) return false;
+            for (auto& unit : context.units)
+            {
+                CacheUnit record;
+                std::memcpy(&record, file + sizeof(CacheHeader) + unit.index * sizeof(CacheUnit), sizeof(record));
+
+                if (record.offset != unit.offset || record.endOffset != unit.endOffset ||
+                    record.entryCount >= DieColumns::noParent || record.droppedNames > record.entryCount ||
+                    record.columnsOffset % 8 != 0 ||
+                    record.columnsOffset > size || _columnsSize(record.entryCount) > size - record.columnsOffset) {
+                    return false;
+                }
+            }
+
+            // Check the name index arrays are within the file. Each count is bounded by the
+            // file size before it is multiplied, so the sizes cannot overflow.
+            if (header.nameCount != 0)
+            {
+                if (header.nameCount > size / sizeof(NameIndex::Name) || header.slotCount > size / sizeof(std::uint32_t) ||
+                    header.idCount > size / sizeof(std::uint64_t) || header.idCount >= NameIndex::emptySlot) {
+                    return false;
+                }
+                std::uint64_t namesSize = _align(header.nameCount * sizeof(NameIndex::Name)) +
+                    _align(header.slotCount * sizeof(std::uint32_t)) + _align(header.idCount * sizeof(std::uint64_t)) +
+                    _align(header.idCount * sizeof(DIEType));
+
+                if (header.namesOffset % 8 != 0 || header.namesOffset > size || namesSize > size - header.namesOffset ||
+                    header.slotCount <= header.nameCount || (header.slotCount & (header.slotCount - 1)) != 0) {
+                    return false;
+                }
+            }
+
+            // Reading every section and the whole file costs more than parsing, so is optional
+            return !verifyContents || (header.sectionsHash == sectionsHash(context) &&
+                header.checksum == _hashBytes(file + sizeof(CacheHeader), size - sizeof(CacheHeader), 0));
+        }
+
+
+        // Borrows the unit's columns from the loaded cache if their contents are valid. The
+        // file's layout has already been checked by validate.
+        static bool adopt(const DwarfContext& context, const CompilationUnit& unit)
+        {
+            auto* file = context.indexCache.get();
+
+            CacheUnit record;
+            std::memcpy(&record, file + sizeof(CacheHeader) + unit.index * sizeof(CacheUnit), sizeof(record));
+            if (!validColumns(context, unit, file, record)) return false;
+
+            auto offset = record.columnsOffset;
+            auto count = record.entryCount;
+
+            unit.entries.tags = borrowArray<DIEType>(file, offset, count);
+            unit.entries.nameSources = borrowArray<NameSource>(file, offset, count);
+            unit.entries.parents = borrowArray<std::uint32_t>(file, offset, count);
+            unit.entries.names = borrowArray<std::uint32_t>(file, offset, count);
+            unit.entries.offsets = borrowArray<std::uint32_t>(file, offset, count);
+            unit.entries.nextSiblings = borrowArray<std::uint32_t>(file, offset, count);
+            unit.entries.subtreeEnds = borrowArray<std::uint32_t>(file, offset, count);
+            unit.entries.droppedNames = static_cast<std::uint32_t>(record.droppedNames);
+            return true;
+        }
+
+
+        static error_t load(DwarfContext& context, const char* path,
+            const std::uint8_t* buildId, std::size_t buildIdSize, bool verifyContents)
+        {
+            if (context.indexCache) return -1;
+
+            int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+            if (fd < 0) return -1;
+
+            struct stat info;
+            if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+                ::close(fd); return -1;
+            }
+            auto size = static_cast<std::size_t>(info.st_size);
+
+            // The mapping remains valid after the descriptor is closed
+            void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (mapping == MAP_FAILED) return -1;
+
+            auto* file = static_cast<const std::uint8_t*>(mapping);
+            if (!validate(context, file, size, buildId, buildIdSize, verifyContents))
+            {
+                ::munmap(mapping, size);
+                return -1;
+            }
+            context.indexCache = std::shared_ptr<const std::uint8_t>(file,
+                [size](const std::uint8_t* file) { ::munmap(const_cast<std::uint8_t*>(file), size); });
+
+            CacheHeader header;
+            std::memcpy(&header, file, sizeof(header));
+
+            // Units adopt their columns as they are first indexed (see adoptCachedIndex). The
+            // name index is adopted now, unless one has been built, and checked as it is used.
+            auto& names = context.nameIndex;
+            if (header.nameCount != 0 && names.empty())
+            {
+                auto offset = header.namesOffset;
+                names.names = borrowArray<NameIndex::Name>(file, offset, header.nameCount);
+                names.slots = borrowArray<std::uint32_t>(file, offset, header.slotCount);
+                names.ids = borrowArray<std::uint64_t>(file, offset, header.idCount);
+                names.tags = borrowArray<DIEType>(file, offset, header.idCount);
+                names.mask = header.slotCount - 1;
+            }
+            return 0;
+        }
+    };
+
+
+    error_t DwarfContext::saveIndexCache(const char* path, const std::uint8_t* buildId, std::size_t buildIdSize) const
+    {
+        return IndexCache::save(*this, path, buildId, buildIdSize);
+    }
+
+    error_t DwarfContext::loadIndexCache(const char* path, const std::uint8_t* buildId, std::size_t buildIdSize,
+        bool verifyContents)
+    {
+        return IndexCache::load(*this, path, buildId, buildIdSize, verifyContents);
+    }
+
+    bool DwarfContext::adoptCachedIndex(const CompilationUnit& unit) const
+    {
+        return IndexCache::adopt(*this, unit);
+    }
+}
@@ -0,0 +1,110 @@
+/* column.hpp - (c) James S Renwick 2020 */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dwarf
+{
+    /* An array of index data which either owns its elements or borrows them read-only,
+       e.g. from a mapped index cache. Only owned columns may be modified; modifying a
+       borrowed column first copies it. */
+    template<typename T>
+    class Column
+    {
+    private:
+        std::vector<T> owned{};
+        const T* _data{};
+        std::size_t _size{};
+        bool borrowed{};
+
+    public:
+        Column() = default;
+        inline Column(std::vector<T>&& elements) noexcept
+            : owned(std::move(elements)), _data(owned.data()), _size(owned.size()) { }
+
+        /* Creates a column viewing the given elements, which must outlive it. */
+        static inline Column borrow(const T* data, std::size_t size) noexcept
+        {
+            Column column;
+            column._data = data; column._size = size; column.borrowed = true;
+            return column;
+        }
+
+        inline Column(const Column& other)
+            : owned(other.owned), _size(other._size), borrowed(other.borrowed) {
+            _data = borrowed ? other._data : owned.data();
+        }
+        inline Column(Column&& other) noexcept
+            : owned(std::move(other.owned)), _data(other._data), _size(other._size), borrowed(other.borrowed) {
+            other.reset();
+        }
+        inline Column& operator=(const Column& other)
+        {
+            if (this != &other) *this = Column(other);
+            return *this;
+        }
+        inline Column& operator=(Column&& other) noexcept
+        {
+            if (this != &other)
+            {
+                owned = std::move(other.owned);
+                _data = other._data; _size = other._size; borrowed = other.borrowed;
+                other.reset();
+            }
+            return *this;
+        }
+
+    public:
+        inline const T& operator[](std::size_t index) const noexcept {
+            return _data[index];
+        }
+        inline const T* data() const noexcept {
+            return _data;
+        }
+        inline std::size_t size() const noexcept {
+            return _size;
+        }
+        inline bool empty() const noexcept {
+            return _size == 0;
+        }
+        inline bool isBorrowed() const noexcept {
+            return borrowed;
+        }
+        inline const T* begin() const noexcept {
+            return _data;
+        }
+        inline const T* end() const noexcept {
+            return _data + _size;
+        }
+
+        inline void push_back(const T& value)
+        {
+            own();
+            owned.push_back(value);
+            _data = owned.data(); _size = owned.size();
+        }
+        inline void set(std::size_t index, const T& value)
+        {
+            own();
+            owned[index] = value;
+        }
+        inline void clear() noexcept
+        {
+            owned.clear();
+            reset();
+        }
+
+    private:
+        inline void reset() noexcept
+        {
+            _data = owned.data(); _size = owned.size(); borrowed = false;
+        }
+        inline void own()
+        {
+            if (!borrowed) return;
+            owned.assign(_data, _data + _size);
+            reset();
+        }
+    };
+}
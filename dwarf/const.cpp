@@ -9,7 +9,9 @@ namespace dwarf
         { AttributeName::None, "" },
         { AttributeName::AbstractOrigin, "AbstractOrigin" },
         { AttributeName::Accessibility, "Accessibility" },
+        { AttributeName::AddrBase, "AddrBase" },
         { AttributeName::AddressClass, "AddressClass" },
+        { AttributeName::Alignment, "Alignment" },
         { AttributeName::Allocated, "Allocated" },
         { AttributeName::Artificial, "Artificial" },
         { AttributeName::Associated, "Associated" },
@@ -20,10 +22,23 @@ namespace dwarf
         { AttributeName::BitStride, "BitStride" },
         { AttributeName::ByteSize, "ByteSize" },
         { AttributeName::ByteStride, "ByteStride" },
+        { AttributeName::CallAllCalls, "CallAllCalls" },
+        { AttributeName::CallAllSourceCalls, "CallAllSourceCalls" },
+        { AttributeName::CallAllTailCalls, "CallAllTailCalls" },
         { AttributeName::CallColumn, "CallColumn" },
+        { AttributeName::CallDataLocation, "CallDataLocation" },
+        { AttributeName::CallDataValue, "CallDataValue" },
         { AttributeName::CallFile, "CallFile" },
         { AttributeName::CallLine, "CallLine" },
         { AttributeName::CallingConvention, "CallingConvention" },
+        { AttributeName::CallOrigin, "CallOrigin" },
+        { AttributeName::CallParameter, "CallParameter" },
+        { AttributeName::CallPC, "CallPC" },
+        { AttributeName::CallReturnPC, "CallReturnPC" },
+        { AttributeName::CallTailCall, "CallTailCall" },
+        { AttributeName::CallTarget, "CallTarget" },
+        { AttributeName::CallTargetClobbered, "CallTargetClobbered" },
+        { AttributeName::CallValue, "CallValue" },
         { AttributeName::CommonReference, "CommonReference" },
         { AttributeName::CompDir, "CompDir" },
         { AttributeName::ConstValue, "ConstValue" },
@@ -39,18 +54,22 @@ namespace dwarf
         { AttributeName::DeclFile, "DeclFile" },
         { AttributeName::DeclLine, "DeclLine" },
         { AttributeName::Declaration, "Declaration" },
+        { AttributeName::Defaulted, "Defaulted" },
         { AttributeName::DefaultValue, "DefaultValue" },
+        { AttributeName::Deleted, "Deleted" },
         { AttributeName::Description, "Description" },
         { AttributeName::DigitCount, "DigitCount" },
         { AttributeName::Discr, "Discr" },
         { AttributeName::DiscrList, "DiscrList" },
         { AttributeName::DiscrValue, "DiscrValue" },
+        { AttributeName::DwoName, "DwoName" },
         { AttributeName::Elemental, "Elemental" },
         { AttributeName::Encoding, "Encoding" },
         { AttributeName::Endianity, "Endianity" },
         { AttributeName::EntryPC, "EntryPC" },
         { AttributeName::EnumClass, "EnumClass" },
         { AttributeName::Explicit, "Explicit" },
+        { AttributeName::ExportSymbols, "ExportSymbols" },
         { AttributeName::Extension, "Extension" },
         { AttributeName::External, "External" },
         { AttributeName::FrameBase, "FrameBase" },
@@ -63,13 +82,16 @@ namespace dwarf
         { AttributeName::Language, "Language" },
         { AttributeName::LinkageName, "LinkageName" },
         { AttributeName::Location, "Location" },
+        { AttributeName::LoclistsBase, "LoclistsBase" },
         { AttributeName::LowPC, "LowPC" },
         { AttributeName::LowerBound, "LowerBound" },
         { AttributeName::MacroInfo, "MacroInfo" },
+        { AttributeName::Macros, "Macros" },
         { AttributeName::MainSubprogram, "MainSubprogram" },
         { AttributeName::Mutable, "Mutable" },
         { AttributeName::Name, "Name" },
         { AttributeName::NamelistItem, "NamelistItem" },
+        { AttributeName::NoReturn, "NoReturn" },
         { AttributeName::ObjectPointer, "ObjectPointer" },
         { AttributeName::Ordering, "Ordering" },
         { AttributeName::PictureString, "PictureString" },
@@ -78,8 +100,12 @@ namespace dwarf
         { AttributeName::Prototyped, "Prototyped" },
         { AttributeName::Pure, "Pure" },
         { AttributeName::Ranges, "Ranges" },
+        { AttributeName::Rank, "Rank" },
         { AttributeName::Recursive, "Recursive" },
+        { AttributeName::Reference, "Reference" },
         { AttributeName::ReturnAddress, "ReturnAddress" },
+        { AttributeName::RnglistsBase, "RnglistsBase" },
+        { AttributeName::RValueReference, "RValueReference" },
         { AttributeName::Segment, "Segment" },
         { AttributeName::Sibling, "Sibling" },
         { AttributeName::Small, "Small" },
@@ -89,6 +115,9 @@ namespace dwarf
         { AttributeName::StaticLink, "StaticLink" },
         { AttributeName::StmtList, "StmtList" },
         { AttributeName::StringLength, "StringLength" },
+        { AttributeName::StringLengthBitSize, "StringLengthBitSize" },
+        { AttributeName::StringLengthByteSize, "StringLengthByteSize" },
+        { AttributeName::StrOffsetsBase, "StrOffsetsBase" },
         { AttributeName::ThreadsScaled, "ThreadsScaled" },
         { AttributeName::Trampoline, "Trampoline" },
         { AttributeName::Type, "Type" },
@@ -68,7 +68,16 @@ namespace dwarf
         SharedType          = 0x40,
         TypeUnit            = 0x41,
         RValueReferenceType = 0x42,
-        TemplateAlias       = 0x43
+        TemplateAlias       = 0x43,
+        // DWARF 5
+        CoarrayType         = 0x44,
+        GenericSubrange     = 0x45,
+        DynamicType         = 0x46,
+        AtomicType          = 0x47,
+        CallSite            = 0x48,
+        CallSiteParameter   = 0x49,
+        SkeletonUnit        = 0x4A,
+        ImmutableType       = 0x4B
     };
 
     enum class AttributeName : std::uint16_t
@@ -76,7 +85,9 @@ namespace dwarf
         None               = 0x0,
         AbstractOrigin     = 0x31, // Instance of inline subprogram
         Accessibility      = 0x32, // C++ declarations, base classes & inherited members
+        AddrBase           = 0x73, // Base of the unit's contribution to .debug_addr
         AddressClass       = 0x33, // std::unique_ptr or reference or function ptr type
+        Alignment          = 0x88, // Non-default alignment of type, subprogram or variable
         Allocated          = 0x4E, // Allocation status of type
         Artificial         = 0x34, // Marks an object or type not actually declared in the source
         Associated         = 0x4F, // Association status
@@ -87,10 +98,23 @@ namespace dwarf
         BitStride          = 0x2E, // Array element, subrange or enum stride
         ByteSize           = 0x0B, // Data object or data type size
         ByteStride         = 0x51, // Type or object size (bytes)
+        CallAllCalls       = 0x7A, // All tail and normal calls in a subprogram are described
+        CallAllSourceCalls = 0x7B, // All calls in a subprogram are described
+        CallAllTailCalls   = 0x7C, // All tail calls in a subprogram are described
         CallColumn         = 0x57, // Column position of inlined subroutine call
+        CallDataLocation   = 0x85, // Memory location of a call parameter's data
+        CallDataValue      = 0x86, // Value of a call parameter's data
         CallFile           = 0x58, // File of inlined subroutine call
         CallLine           = 0x59, // Line number of inlined subroutine call
         CallingConvention  = 0x36, // Subprogram calling convention
+        CallOrigin         = 0x7F, // Subprogram called
+        CallParameter      = 0x80, // Parameter of a call
+        CallPC             = 0x81, // Address of the call instruction
+        CallReturnPC       = 0x7D, // Return address of a call
+        CallTailCall       = 0x82, // Call is a tail call
+        CallTarget         = 0x83, // Address of the called subprogram
+        CallTargetClobbered = 0x84, // Address of the called subprogram, clobbered by the call
+        CallValue          = 0x7E, // Value of a call parameter
         CommonReference    = 0x1A, // Common block usage
         CompDir            = 0x1B, // Compilation directory
         ConstValue         = 0x1C, // Constant, enum literal, template value
@@ -106,18 +130,22 @@ namespace dwarf
         DeclFile           = 0x3A, // File containing source declaration
         DeclLine           = 0x3B, // Line number of source declaration
         Declaration        = 0x3C, // Incomplete, non-defining or separate entity declartion
+        Defaulted          = 0x8B, // Member function defaulted
         DefaultValue       = 0x1E, // Default value of a parameter
+        Deleted            = 0x8A, // Member function deleted
         Description        = 0x5A, // Artificial name or description
         DigitCount         = 0x5F, // Digit count for packed decimal or numeric string type
         Discr              = 0x15, // Disriminant of variant part
         DiscrList          = 0x3D, // IList of discriminant values
         DiscrValue         = 0x16,
+        DwoName            = 0x76, // Name of the split DWARF object file
         Elemental          = 0x66, // Elemental property of a subroutine
         Encoding           = 0x3E, // Encoding of a base type
         Endianity          = 0x65, // Endianity of data
         EntryPC            = 0x52, // Entry address of module init or (inlined-)subprogram
         EnumClass          = 0x6D, // Type-safe enumeration definition
         Explicit           = 0x63, // Explicit property of a member function
+        ExportSymbols      = 0x89, // Export symbols of a namespace or structure
         Extension          = 0x54, // Previous namespace extension or original namespace
         External           = 0x3F, // External subroutine or variable
         FrameBase          = 0x40, // Subroutine frame base address
@@ -130,13 +158,16 @@ namespace dwarf
         Language           = 0x13, // Programming language
         LinkageName        = 0x6E, // Object file linkage name of an entity
         Location           = 0x02, // Data object location
+        LoclistsBase       = 0x8C, // Base of the unit's offset table in .debug_loclists
         LowPC              = 0x11, // Code address or range of addresses
         LowerBound         = 0x22, // Lower bound of subrange
         MacroInfo          = 0x43, // Macro information
+        Macros             = 0x79, // Macro information in .debug_macro
         MainSubprogram     = 0x6A, // Main or starting subprogram or unit containing such
         Mutable            = 0x61, // Mutable property of member data
         Name               = 0x03, // Name of declaration or path name of compilation source
         NamelistItem       = 0x44, // Namelist item
+        NoReturn           = 0x87, // Subprogram does not return
         ObjectPointer      = 0x64, // Object (this, self) pointer of member interface
         Ordering           = 0x09, // Array row/column ordering
         PictureString      = 0x60, // Picture string for numeric string type
@@ -145,8 +176,12 @@ namespace dwarf
         Prototyped         = 0x27, // Subroutine prototype
         Pure               = 0x67, // Pure property of a subroutine
         Ranges             = 0x55, // Non-contiguous range of code addresses
+        Rank               = 0x71, // Dynamic number of array dimensions
         Recursive          = 0x68, // Recursive property of a subroutine
+        Reference          = 0x77, // &-qualified non-static member function
         ReturnAddress      = 0x2A, // Subroutine return address save location
+        RnglistsBase       = 0x74, // Base of the unit's offset table in .debug_rnglists
+        RValueReference    = 0x78, // &&-qualified non-static member function
         Segment            = 0x46, // Addressing information
         Sibling            = 0x01, // Debugging information entry relationship
         Small              = 0x5D, // Scale factor for fixed-point type
@@ -156,6 +191,9 @@ namespace dwarf
         StaticLink         = 0x48, // Location of uplevel frame
         StmtList           = 0x10, // Line number information for unit
         StringLength       = 0x19, // String length of string type
+        StringLengthBitSize = 0x6F, // Size of a string length in bits
+        StringLengthByteSize = 0x70, // Size of a string length in bytes
+        StrOffsetsBase     = 0x72, // Base of the unit's contribution to .debug_str_offsets
         ThreadsScaled      = 0x62, // UPC array bound THREADS scale factor
         Trampoline         = 0x56, // Target subroutine
         Type               = 0x49, // Type of declaration or subroutine return
@@ -200,6 +238,37 @@ namespace dwarf
         ExprLoc     = 0x18, // DWARF Expression or Location Description
         FlagPresent = 0x19, // Single-byte flag
         RefSig8     = 0x20,
+        // DWARF 5
+        Strx        = 0x1A, // Index into the unit's .debug_str_offsets contribution
+        Addrx       = 0x1B, // Index into the unit's .debug_addr contribution
+        RefSup4     = 0x1C,
+        StrpSup     = 0x1D,
+        Data16      = 0x1E,
+        LineStrp    = 0x1F, // Offset into .debug_line_str
+        ImplicitConst = 0x21, // Constant held in the abbreviation rather than the DIE
+        Loclistx    = 0x22, // Index into the unit's .debug_loclists offset table
+        Rnglistx    = 0x23, // Index into the unit's .debug_rnglists offset table
+        RefSup8     = 0x24,
+        Strx1       = 0x25,
+        Strx2       = 0x26,
+        Strx3       = 0x27,
+        Strx4       = 0x28,
+        Addrx1      = 0x29,
+        Addrx2      = 0x2A,
+        Addrx3      = 0x2B,
+        Addrx4      = 0x2C
+    };
+
+    // Unit header types (DWARF 5)
+    enum class UnitType : std::uint8_t
+    {
+        None         = 0x00,
+        Compile      = 0x01,
+        Type         = 0x02,
+        Partial      = 0x03,
+        Skeleton     = 0x04,
+        SplitCompile = 0x05,
+        SplitType    = 0x06
     };
 
     enum class AttributeClass
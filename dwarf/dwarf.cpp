@@ -1,5 +1,7 @@
 #include "dwarf.hpp"
 #include "format.hpp"
+#include <algorithm>
+#include <atomic>
 #include <cstring>
 
 namespace dwarf
@@ -7,37 +9,77 @@ namespace dwarf
 
     SectionType SectionTypeFromString(const char* name)
     {
-        if (std::strcmp(name, ".debug_info") == 0) {
+        // Accept both .debug_* and compressed .zdebug_* names
+        if (std::strncmp(name, ".debug_", 7) == 0) name += 1;
+        else if (std::strncmp(name, ".zdebug_", 8) == 0) name += 2;
+        else return SectionType::invalid;
+
+        if (std::strcmp(name, "debug_info") == 0) {
             return dwarf::SectionType::debug_info;
         }
-        else if (std::strcmp(name, ".debug_abbrev") == 0) {
+        else if (std::strcmp(name, "debug_abbrev") == 0) {
             return dwarf::SectionType::debug_abbrev;
         }
-        else if (std::strcmp(name, ".debug_aranges") == 0) {
+        else if (std::strcmp(name, "debug_aranges") == 0) {
             return dwarf::SectionType::debug_aranges;
         }
-        else if (std::strcmp(name, ".debug_ranges") == 0) {
+        else if (std::strcmp(name, "debug_ranges") == 0) {
             return dwarf::SectionType::debug_ranges;
         }
-        else if (std::strcmp(name, ".debug_line") == 0) {
+        else if (std::strcmp(name, "debug_line") == 0) {
             return dwarf::SectionType::debug_line;
         }
-        else if (std::strcmp(name, ".debug_str") == 0) {
+        else if (std::strcmp(name, "debug_str") == 0) {
             return dwarf::SectionType::debug_str;
         }
+        else if (std::strcmp(name, "debug_str_offsets") == 0) {
+            return dwarf::SectionType::debug_str_offsets;
+        }
+        else if (std::strcmp(name, "debug_addr") == 0) {
+            return dwarf::SectionType::debug_addr;
+        }
+        else if (std::strcmp(name, "debug_rnglists") == 0) {
+            return dwarf::SectionType::debug_rnglists;
+        }
+        else if (std::strcmp(name, "debug_loclists") == 0) {
+            return dwarf::SectionType::debug_loclists;
+        }
+        else if (std::strcmp(name, "debug_line_str") == 0) {
+            return dwarf::SectionType::debug_line_str;
+        }
         else return SectionType::invalid;
     }
 
+    const char* SectionTypeToString(SectionType type)
+    {
+        switch (type)
+        {
+            case SectionType::debug_info:    return ".debug_info";
+            case SectionType::debug_abbrev:  return ".debug_abbrev";
+            case SectionType::debug_aranges: return ".debug_aranges";
+            case SectionType::debug_ranges:  return ".debug_ranges";
+            case SectionType::debug_line:    return ".debug_line";
+            case SectionType::debug_str:     return ".debug_str";
+            case SectionType::debug_str_offsets: return ".debug_str_offsets";
+            case SectionType::debug_addr:     return ".debug_addr";
+            case SectionType::debug_rnglists: return ".debug_rnglists";
+            case SectionType::debug_loclists: return ".debug_loclists";
+            case SectionType::debug_line_str: return ".debug_line_str";
+            default: return nullptr;
+        }
+    }
+
 
 
 
 
-    DwarfSection::DwarfSection(const DwarfSection& other) : type(other.type), size(other.size)
+    DwarfSection::DwarfSection(const DwarfSection& other) : type(other.type), size(other.size), fileOffset(other.fileOffset)
     {
         if (other.data.ownsData())
         {
-            data.reset(new std::uint8_t[size], true);
-            std::memcpy(this->data.get(), other.data.get(), size);
+            auto* copy = new std::uint8_t[size];
+            std::memcpy(copy, other.data.get(), size);
+            data.reset(copy, true);
         }
         else data.reset(other.data.get(), false);
     }
@@ -46,9 +88,10 @@ namespace dwarf
     {
         if (this == &other) return *this;
 
-        type = other.type; size = other.size;
-        data.reset(new std::uint8_t[size], true);
-        std::memcpy(this->data.get(), other.data.get(), size);
+        type = other.type; size = other.size; fileOffset = other.fileOffset;
+        auto* copy = new std::uint8_t[size];
+        std::memcpy(copy, other.data.get(), size);
+        data.reset(copy, true);
 
         return *this;
     }
@@ -74,16 +117,29 @@ namespace dwarf
         switch (attr.form) {
             // AttributeClass::Address
             case AttributeForm::Address: return addressSize;
+            case AttributeForm::Addrx: { std::uint64_t _; return uleb_read(value, valueLength, _); }
+            case AttributeForm::Addrx1: return 1;
+            case AttributeForm::Addrx2: return 2;
+            case AttributeForm::Addrx3: return 3;
+            case AttributeForm::Addrx4: return 4;
             // AttributeClass::Block
-            case AttributeForm::Block1: return *(value++);
-            case AttributeForm::Block2: { std::uint16_t size; std::memcpy(&size, value, 2); value += 2; return size; }
-            case AttributeForm::Block4: { std::uint32_t size; std::memcpy(&size, value, 4); value += 4; return size; }
+            case AttributeForm::Block1: if (valueLength < 1) break; return *(value++);
+            case AttributeForm::Block2: {
+                if (valueLength < 2) break;
+                std::uint16_t size; std::memcpy(&size, value, 2); value += 2; return size;
+            }
+            case AttributeForm::Block4: {
+                if (valueLength < 4) break;
+                std::uint32_t size; std::memcpy(&size, value, 4); value += 4; return size;
+            }
             case AttributeForm::Block:  { std::uint64_t size; value += uleb_read(value, valueLength, size); return size; }
             // AttributeClass::Constant
             case AttributeForm::Data1: return 1;
             case AttributeForm::Data2: return 2;
             case AttributeForm::Data4: return 4;
             case AttributeForm::Data8: return 8;
+            case AttributeForm::Data16: return 16;
+            case AttributeForm::ImplicitConst: return 0;
             case AttributeForm::SData: { std::uint64_t _; return uleb_read(value, valueLength, _); }
             case AttributeForm::UData: { std::uint64_t _; return uleb_read(value, valueLength, _); }
             // AttributeClass::ExprLoc
@@ -94,6 +150,8 @@ namespace dwarf
             case AttributeForm::FlagPresent: return 0;
             // AttributeClass::SectionPointer
             case AttributeForm::SecOffset: return dwarfWidth;
+            case AttributeForm::Loclistx: { std::uint64_t _; return uleb_read(value, valueLength, _); }
+            case AttributeForm::Rnglistx: { std::uint64_t _; return uleb_read(value, valueLength, _); }
             // AttributeClass::UnitReference
             case AttributeForm::Ref1: return 1;
             case AttributeForm::Ref2: return 2;
@@ -103,65 +161,141 @@ namespace dwarf
             case AttributeForm::RefSig8: return 8;
             // AttributeClass::Reference
             case AttributeForm::RefAddr: return dwarfWidth;
+            case AttributeForm::RefSup4: return 4;
+            case AttributeForm::RefSup8: return 8;
             // AttributeClass::String
-            case AttributeForm::String: return strlen(reinterpret_cast<const char*>(value)) + 1;
+            case AttributeForm::String: return strnlen(reinterpret_cast<const char*>(value), valueLength) + 1;
             case AttributeForm::Strp: return dwarfWidth;
+            case AttributeForm::LineStrp: return dwarfWidth;
+            case AttributeForm::StrpSup: return dwarfWidth;
+            case AttributeForm::Strx: { std::uint64_t _; return uleb_read(value, valueLength, _); }
+            case AttributeForm::Strx1: return 1;
+            case AttributeForm::Strx2: return 2;
+            case AttributeForm::Strx3: return 3;
+            case AttributeForm::Strx4: return 4;
         }
         // Indicate error - unknown form
         return static_cast<std::size_t>(-1);
     }
 
 
-	extern std::size_t readHeader(const std::uint8_t* buffer, std::size_t length,
-		std::uint64_t& id_out, std::uint32_t& type_out);
-
-
     class DebugEntryParser
     {
     public:
-        static std::uint32_t nextAbbreviation(const std::uint8_t* buffer, std::size_t length,
-            std::uint64_t& abbrevID_out)
+        // Gets the size of the given attribute's value, advancing 'value' and 'length' past
+        // any length prefix. Returns -1 upon error.
+        static std::size_t valueSize(const AbbreviationAttribute& attr, const CompilationUnit& unit,
+            const std::uint8_t*& value, std::size_t& length)
         {
-            const std::uint8_t* origBuffer = buffer;
+            if (attr.isFixedSize()) {
+                return attr.size <= length ? attr.size : static_cast<std::size_t>(-1);
+            }
+            const std::uint8_t* start = value;
+            auto size = attributeSize(attr, unit.header->addressSize(),
+                unit.width == DwarfWidth::Bits64 ? 8 : 4, value, length);
+            length -= value - start;
 
-            std::uint32_t tag = 0;
-            bool hasChildren = false;
+            return size <= length ? size : static_cast<std::size_t>(-1);
+        }
 
-            // Read header
-			auto size = readHeader(buffer, length, abbrevID_out, tag);
-			buffer += size; length -= size;
 
-            // Terminate if null entry
-            if (abbrevID_out == 0) return buffer - origBuffer;
+        // Creates an attribute over the given value. The value of an implicit constant is
+        // held by the abbreviation instead.
+        static inline Attribute makeAttribute(const AbbreviationAttribute& attr, const std::uint8_t* value,
+            std::size_t size) noexcept
+        {
+            if (attr.form == AttributeForm::ImplicitConst) {
+                return Attribute(attr, reinterpret_cast<const std::uint8_t*>(&attr.implicitConst),
+                    sizeof(attr.implicitConst));
+            }
+            return Attribute(attr, value, size);
+        }
+
 
-            // Skip over 'hasChildren'
-			buffer++; length--;
+        // Gets the total size of a DIE's attribute values. Fixed-size values are skipped in a
+        // single add, so only variable-size values are decoded. Also gets the offsets of the
+        // values in the given slots (noAttribute for none). Returns -1 upon error.
+        template<std::size_t N>
+        static std::size_t skipAttributes(const Abbreviation& abbrev, const CompilationUnit& unit,
+            const std::uint8_t* buffer, std::size_t length, const std::uint32_t (&slots)[N],
+            std::size_t (&slotOffsets_out)[N])
+        {
+            std::size_t variableBytes = 0;
+            for (auto& offset : slotOffsets_out) offset = static_cast<std::size_t>(-1);
 
-            // Skip attributes
-            while (true)
+            // Slots up to and including 'i' follow exactly 'variableBytes' of variable-size values
+            auto locateSlots = [&](std::uint32_t i)
+            {
+                for (std::size_t s = 0; s < N; s++)
+                {
+                    if (slots[s] <= i && slots[s] < abbrev.attributeCount &&
+                        slotOffsets_out[s] == static_cast<std::size_t>(-1)) {
+                        slotOffsets_out[s] = abbrev.attributes[slots[s]].fixedOffset + variableBytes;
+                    }
+                }
+            };
+            auto skipSlot = [&](std::uint32_t i) -> bool
             {
-				AttributeSpecification _;
-				auto size = AttributeSpecification::parse(buffer, length, _);
+                locateSlots(i);
 
-				buffer += size; length -= size;
-                if (_.name == AttributeName::None && _.form == AttributeForm::None) break;
+                auto& attr = abbrev.attributes[i];
+                std::size_t offset = attr.fixedOffset + variableBytes;
+                if (offset > length) return false;
+
+                const std::uint8_t* value = buffer + offset;
+                std::size_t remaining = length - offset;
+                auto size = valueSize(attr, unit, value, remaining);
+                if (size == static_cast<std::size_t>(-1)) return false;
+
+                variableBytes += (value - (buffer + offset)) + size;
+                return true;
+            };
+
+            if (abbrev.hasCompleteMask())
+            {
+                for (std::uint64_t mask = abbrev.variableMask; mask != 0; mask &= mask - 1) {
+                    if (!skipSlot(static_cast<std::uint32_t>(__builtin_ctzll(mask)))) return static_cast<std::size_t>(-1);
+                }
             }
-            return buffer - origBuffer;
+            else
+            {
+                for (std::uint32_t i = 0; i < abbrev.attributeCount; i++) {
+                    if (!abbrev.attributes[i].isFixedSize() && !skipSlot(i)) return static_cast<std::size_t>(-1);
+                }
+            }
+            locateSlots(abbrev.attributeCount);
+
+            std::size_t size = abbrev.fixedSize + variableBytes;
+            return size <= length ? size : static_cast<std::size_t>(-1);
+        }
+
+
+        // Reads a DW_AT_sibling value as an offset into .debug_info. Returns false if the
+        // sibling is not within the unit.
+        static bool readSibling(const AbbreviationAttribute& attr, const CompilationUnit& unit,
+            const std::uint8_t* value, std::size_t length, std::uint64_t& offset_out)
+        {
+            std::uint64_t reference = 0;
+            if (attr.form == AttributeForm::RefUData) uleb_read(value, length, reference);
+            else if (attr.isFixedSize() && attr.size <= sizeof(reference)) std::memcpy(&reference, value, attr.size);
+            else return false;
+
+            // All but DW_FORM_ref_addr are relative to the unit
+            offset_out = attr.form == AttributeForm::RefAddr ? reference : unit.offset + reference;
+            return offset_out >= unit.dieOffset && offset_out < unit.endOffset;
         }
 
 
         static std::uint32_t nextDIE(const std::uint8_t* buffer, std::size_t length,
-            const DwarfContext& context, std::uint64_t& abbrevID_out,
-            DIEType& type_out, const char*& name_out, bool& hasChildren_out)
+            const DwarfContext& context, const CompilationUnit& unit, std::uint64_t& abbrevID_out,
+            DIEType& type_out, const char*& name_out, bool& hasChildren_out, std::uint64_t& sibling_out)
         {
             const std::uint8_t* origBuffer = buffer;
 
             hasChildren_out = false;
             name_out = nullptr;
 			type_out = DIEType::None;
-
-            auto& debug_abbrev = context[SectionType::debug_abbrev];
-            if (!debug_abbrev) return 0;
+            sibling_out = 0;
 
             // Read header
             auto size = dwarf::uleb_read(buffer, length, abbrevID_out);
@@ -169,223 +303,554 @@ namespace dwarf
             // Terminate if null entry
             if (abbrevID_out == 0) return buffer - origBuffer;
 
-            // Get abbreviation data from index
-            auto index = context.abbreviationIndex.at(abbrevID_out);
-            const std::uint8_t* origAbbrevData = debug_abbrev.data.get();
-            const std::uint8_t* abbrevData = origAbbrevData + index;
+            // Get compiled abbreviation from the unit's table
+            auto* abbrev = unit.abbreviations->find(abbrevID_out);
+            if (abbrev == nullptr) return static_cast<std::uint32_t>(-1);
 
-            // Read abbreviation header
-			std::uint64_t _; std::uint32_t tag;
-			abbrevData += readHeader(abbrevData, debug_abbrev.size - (abbrevData - origAbbrevData), _, tag);
-            type_out = static_cast<DIEType>(tag);
-
-            hasChildren_out = abbrevData[0];
-            abbrevData++;
-
-            // Handle attributes
-            while (true)
-            {
-                // Read abbreviation attribute specifications
-                AttributeSpecification attr;
-                abbrevData += AttributeSpecification::parse(abbrevData,
-                    debug_abbrev.size - (abbrevData - origAbbrevData), attr);
+            type_out = abbrev->tag;
+            hasChildren_out = abbrev->hasChildren;
 
-                // Break upon NULL specification
-                if (attr.name == AttributeName::None &&
-                    attr.form == AttributeForm::None) break;
+            // Skip over the attribute values, finding the 'name' and 'sibling' values if present
+            std::uint32_t slots[] = { abbrev->nameAttribute, abbrev->siblingAttribute };
+            std::size_t offsets[2];
+            std::size_t valuesSize;
+            if (abbrev->isFixedSize() && abbrev->nameAttribute == Abbreviation::noAttribute &&
+                abbrev->siblingAttribute == Abbreviation::noAttribute) {
+                valuesSize = abbrev->fixedSize <= length ? abbrev->fixedSize : static_cast<std::size_t>(-1);
+            }
+            else valuesSize = skipAttributes(*abbrev, unit, buffer, length, slots, offsets);
 
-                // Get attribute size
-                auto size = attributeSize(attr, context.unitHeader().addressSize(),
-					context.width == DwarfWidth::Bits64 ? 8 : 4, buffer, length);
+            if (valuesSize == static_cast<std::size_t>(-1)) return static_cast<std::uint32_t>(-1);
 
-                if (size == static_cast<std::size_t>(-1)) return static_cast<std::uint32_t>(-1);
+            if (abbrev->nameAttribute != Abbreviation::noAttribute)
+            {
+                auto& attr = abbrev->attributes[abbrev->nameAttribute];
+                const std::uint8_t* value = buffer + offsets[0];
 
-                // Pull out 'name' attribute value
-                if (attr.name == AttributeName::Name)
+                if (attr.form == AttributeForm::String) {
+                    name_out = reinterpret_cast<const char*>(value);
+                }
+                else if (attr.form == AttributeForm::Strp)
                 {
-                    if (attr.form == AttributeForm::String) {
-                        name_out = reinterpret_cast<const char*>(buffer);
+                    auto& debug_str = context[SectionType::debug_str];
+                    std::uint64_t offset = 0;
+                    std::memcpy(&offset, value, attr.size);
+
+                    if (debug_str && offset < debug_str.size) {
+                        name_out = reinterpret_cast<const char*>(debug_str.data.get() + offset);
                     }
-                    else if (attr.form == AttributeForm::Strp)
-                    {
-                        auto& debug_str = context[SectionType::debug_str];
-                        if (debug_str)
-                        {
-                            std::uint64_t offset = 0;
-                            std::memcpy(&offset, buffer, size);
-                            name_out = reinterpret_cast<const char*>(debug_str.data.get() + offset);
-                        }
+                }
+                // DWARF 5 names may instead be in .debug_line_str or indexed
+                else if (attr.class_ == AttributeClass::String)
+                {
+                    std::size_t remaining = length - offsets[0];
+                    auto size = valueSize(attr, unit, value, remaining);
+                    if (size != static_cast<std::size_t>(-1)) {
+                        name_out = context.attributeString(unit, Attribute(attr, value, size));
                     }
                 }
-                // Advance buffer past value
-                buffer += size;
             }
-
-            return buffer - origBuffer;
+            if (abbrev->siblingAttribute != Abbreviation::noAttribute && hasChildren_out)
+            {
+                std::uint64_t sibling;
+                if (readSibling(abbrev->attributes[abbrev->siblingAttribute], unit,
+                    buffer + offsets[1], length - offsets[1], sibling)) sibling_out = sibling;
+            }
+            return (buffer - origBuffer) + valuesSize;
         }
 
 
-        static std::size_t parseDIEChain(const std::uint8_t* buffer, std::size_t bufferSize,
-            DwarfContext& context, const std::uint8_t* sectionStart, std::uint64_t parentDIE)
+        // Skips the children of a DIE, jumping over nested subtrees using DW_AT_sibling where
+        // present. Returns the number of bytes skipped, including the terminating null entry,
+        // or -1 upon error.
+        static std::size_t skipChildren(const std::uint8_t* buffer, std::size_t length,
+            const DwarfContext& context, const CompilationUnit& unit, const std::uint8_t* sectionStart)
         {
             const std::uint8_t* bufferStart = buffer;
-            while (true)
+            const std::uint8_t* bufferEnd = buffer + length;
+
+            for (std::size_t depth = 1; depth != 0; )
             {
-                // Parse next DIE
-                std::uint64_t abbrevID; DIEType dietype; const char* name; bool hasChildren;
-                auto size = nextDIE(buffer, bufferSize, context, abbrevID, dietype, name, hasChildren);
+                std::uint64_t abbrevID, sibling; DIEType dietype; const char* name; bool hasChildren;
+                auto size = nextDIE(buffer, bufferEnd - buffer, context, unit, abbrevID, dietype, name, hasChildren, sibling);
+                if (size == static_cast<std::uint32_t>(-1)) return static_cast<std::size_t>(-1);
 
-                // Update buffer view
-                bufferSize -= size;
+                // Null entries end a chain of siblings; running out of data is an error
+                if (abbrevID == 0)
+                {
+                    if (size == 0) return static_cast<std::size_t>(-1);
+                    buffer += size; depth--;
+                    continue;
+                }
                 buffer += size;
 
-                // Break upon NULL entry
-                if (abbrevID == 0) break;
-
-                // Add DIE to index
-                auto index = context.entryIndex.size();
-                context.entryIndex.emplace_back(
-                    dietype, parentDIE, name, buffer - sectionStart);
-
-                // Process children if present
                 if (hasChildren)
                 {
-                    auto offset = parseDIEChain(buffer, bufferSize, context, sectionStart, index);
-                    bufferSize -= offset;
-                    buffer += offset;
+                    // Jump straight to the next sibling if known, otherwise descend
+                    if (sibling != 0 && sectionStart + sibling > buffer && sectionStart + sibling <= bufferEnd) {
+                        buffer = sectionStart + sibling;
+                    }
+                    else depth++;
                 }
             }
             return buffer - bufferStart;
         }
 
 
-        static error_t buildIndexes(DwarfContext& context)
+        // Lists the DIEs of a unit in order. In TraversalMode::TopLevel, only the unit DIE and
+        // its children are listed and the subtree of each child is skipped.
+        static error_t traverse(const DwarfContext& context, const CompilationUnit& unit,
+            TraversalMode mode, DIEType filter, std::vector<DieLocation>& entries_out)
         {
-            auto& debug_abbrev = context[SectionType::debug_abbrev];
             auto& debug_info = context[SectionType::debug_info];
+            if (!debug_info || context.prepareUnit(unit) != 0) return -1;
+
+            const std::uint8_t* sectionStart = debug_info.data.get();
+            const std::uint8_t* buffer = sectionStart + unit.dieOffset;
+            const std::uint8_t* bufferEnd = sectionStart + unit.endOffset;
 
-            // Index abbreviation table - this must be done first
+            for (std::size_t depth = 0; buffer < bufferEnd; )
             {
-                const std::uint8_t* buffer = debug_abbrev.data.get();
-                std::uint32_t bufferSize = debug_abbrev.size;
+                std::uint64_t abbrevID, sibling; DIEType dietype; const char* name; bool hasChildren;
+                auto size = nextDIE(buffer, bufferEnd - buffer, context, unit, abbrevID, dietype, name, hasChildren, sibling);
+                if (size == static_cast<std::uint32_t>(-1)) return -1;
 
-                while (true)
+                if (abbrevID == 0)
                 {
-                    // Parse next abbreviation
-                    std::uint64_t abbrevID;
-                    auto size = nextAbbreviation(buffer, bufferSize, abbrevID);
-                    if (abbrevID == 0) break;
+                    buffer += size;
+                    if (depth == 0) break;
+                    depth--; continue;
+                }
 
-                    // Store ID<->offset in index
-                    context.abbreviationIndex[abbrevID] = buffer - debug_abbrev.data.get();
+                if (filter == DIEType::None || filter == dietype) {
+                    entries_out.push_back(DieLocation{ static_cast<std::uint64_t>(buffer - sectionStart),
+                        dietype, depth, name, hasChildren });
+                }
+                buffer += size;
 
-                    // Update buffer view
-                    bufferSize -= size;
-                    buffer += size;
+                if (!hasChildren) continue;
+
+                // Skip the subtrees of the unit DIE's children in top-level mode
+                if (mode == TraversalMode::TopLevel && depth == 1)
+                {
+                    // As in skipChildren, a sibling must lie past the DIE and within the unit
+                    if (sibling != 0 && sectionStart + sibling > buffer && sectionStart + sibling <= bufferEnd) {
+                        buffer = sectionStart + sibling;
+                    }
+                    else
+                    {
+                        auto skipped = skipChildren(buffer, bufferEnd - buffer, context, unit, sectionStart);
+                        if (skipped == static_cast<std::size_t>(-1)) return -1;
+                        buffer += skipped;
+                    }
                 }
+                else depth++;
+            }
+            return 0;
+        }
+
+
+        // Finds the section holding a DIE's name and its offset within it (or within the unit,
+        // if inline). Names whose offset does not fit in 32 bits are not indexed.
+        static NameSource nameReference(const DwarfContext& context, const CompilationUnit& unit,
+            const char* name, std::uint32_t& offset_out)
+        {
+            offset_out = 0;
+            if (name == nullptr) return NameSource::None;
+
+            auto* address = reinterpret_cast<const std::uint8_t*>(name);
+            auto& debug_str = context[SectionType::debug_str];
+            auto& debug_line_str = context[SectionType::debug_line_str];
+            auto& debug_info = context[SectionType::debug_info];
+
+            NameSource source;
+            std::uint64_t offset;
+            if (debug_str && address >= debug_str.data.get() && address < debug_str.data.get() + debug_str.size) {
+                source = NameSource::Str; offset = address - debug_str.data.get();
             }
+            else if (debug_line_str && address >= debug_line_str.data.get() &&
+                address < debug_line_str.data.get() + debug_line_str.size) {
+                source = NameSource::LineStr; offset = address - debug_line_str.data.get();
+            }
+            else { source = NameSource::Inline; offset = address - (debug_info.data.get() + unit.offset); }
+
+            if (offset > static_cast<std::uint32_t>(-1)) return NameSource::None;
+            offset_out = static_cast<std::uint32_t>(offset);
+            return source;
+        }
+
+
+        // Parses the DIEs of the indexer's unit into its entries, using an explicit stack of
+        // open sibling chains. Stops early once either budget (if not 0) is used up, leaving
+        // the indexer ready to continue. Parent ids are positions within the entries.
+        static error_t parseDIEs(UnitIndexer& indexer, std::size_t byteBudget, std::size_t dieBudget)
+        {
+            if (indexer.failed) return -1;
+
+            auto& context = *indexer.context;
+            auto& unit = *indexer.unit;
+            auto& entries = indexer.entries;
+            auto& scopes = indexer.scopes;
+
+            const std::uint8_t* section = context[SectionType::debug_info].data.get();
+            const std::uint8_t* unitStart = section + unit.offset;
+            const std::uint8_t* unitEnd = section + unit.endOffset;
+            const std::uint8_t* buffer = section + indexer.offset;
+            const std::uint8_t* bufferStart = buffer;
 
-            // Index debug info entry table
+            for (std::size_t count = 0; !scopes.empty(); )
             {
-                const std::uint8_t* buffer = debug_info.data.get();
-                std::uint32_t bufferSize = debug_info.size;
+                if ((byteBudget != 0 && static_cast<std::size_t>(buffer - bufferStart) >= byteBudget) ||
+                    (dieBudget != 0 && count >= dieBudget)) break;
 
-                // Skip past program header
-				auto headerSize = context.width == DwarfWidth::Bits64 ?
-					sizeof(CompilationUnitHeader64) : sizeof(CompilationUnitHeader32);
+                // Parse next DIE
+                std::uint64_t abbrevID, sibling; DIEType dietype; const char* name; bool hasChildren;
+                auto size = nextDIE(buffer, unitEnd - buffer, context, unit, abbrevID, dietype, name, hasChildren, sibling);
 
-                buffer += headerSize; bufferSize -= headerSize;
+                // The end of the unit may only close the outermost chain; as in skipChildren,
+                // running out of data within a DIE's children is an error
+                bool truncated = abbrevID == 0 && size == 0 && scopes.size() > 1;
+                if (size == static_cast<std::uint32_t>(-1) || truncated || entries.size() >= DieColumns::noParent)
+                {
+                    indexer.failed = true;
+                    entries = DieColumns{};
+                    return -1;
+                }
+                buffer += size;
 
-                parseDIEChain(buffer, bufferSize, context, debug_info.data.get(), 0);
+                // A NULL entry (or the end of the unit) closes the innermost chain
+                if (abbrevID == 0)
+                {
+                    auto parent = scopes.back().parent;
+                    if (parent != DieColumns::noParent) {
+                        entries.subtreeEnds.set(parent, static_cast<std::uint32_t>(entries.size()));
+                    }
+                    scopes.pop_back();
+                    continue;
+                }
+
+                // Add DIE to index
+                auto& scope = scopes.back();
+                auto index = static_cast<std::uint32_t>(entries.size());
+
+                std::uint32_t nameOffset;
+                auto nameSource = nameReference(context, unit, name, nameOffset);
+                if (name != nullptr && nameSource == NameSource::None) entries.droppedNames++;
+
+                entries.tags.push_back(dietype);
+                entries.nameSources.push_back(nameSource);
+                entries.parents.push_back(scope.parent);
+                entries.names.push_back(nameOffset);
+                entries.offsets.push_back(static_cast<std::uint32_t>(buffer - size - unitStart));
+                entries.nextSiblings.push_back(DieColumns::noSibling);
+                entries.subtreeEnds.push_back(index + 1);
+
+                // Link from the previous sibling
+                if (scope.previous != DieColumns::noSibling) entries.nextSiblings.set(scope.previous, index);
+                scope.previous = index;
+                count++;
+
+                // Open a chain for the children if present
+                if (hasChildren) scopes.push_back({ index, DieColumns::noSibling });
             }
+
+            indexer.offset = buffer - section;
             return 0;
         }
 
 
-        static DebugInfoEntry dieFromId(std::uint64_t id, DwarfContext& context)
+        // Reads a unit header of the given layout, following an initial length of 'lengthSize' bytes
+        template<typename Header, typename HeaderImpl>
+        static bool readUnitHeader(const std::uint8_t* buffer, std::size_t length, std::size_t lengthSize,
+            CompilationUnit& unit_out)
         {
-            auto& index = context.entryIndex[id];
-            auto offset = std::get<3>(index);
-
-            auto& debug_info = context[SectionType::debug_info];
-            auto& debug_abbrev = context[SectionType::debug_abbrev];
+            Header header;
+            if (length < sizeof(header)) return false;
+            std::memcpy(&header, buffer, sizeof(header));
+
+            unit_out.dieOffset = unit_out.offset + sizeof(header);
+            unit_out.endOffset = unit_out.offset + lengthSize + header.unitLength;
+            unit_out.header.reset(new HeaderImpl(header));
+            return true;
+        }
 
-            const std::uint8_t* origBuffer = debug_info.data.get() + offset;
-            const std::uint8_t* buffer = origBuffer;
+        // Reads the header of the unit at the given offset into .debug_info
+        static bool readUnitHeader(const DwarfSection& debug_info, std::uint64_t offset,
+            CompilationUnit& unit_out)
+        {
+            const std::uint8_t* buffer = debug_info.data.get() + offset;
             std::size_t length = debug_info.size - offset;
 
-            const std::uint8_t* origAbbrevData = debug_abbrev.data.get();
-            const std::uint8_t* abbrevData = origAbbrevData;
+            // 64-bit units begin with the escape 0xffffffff
+            std::uint32_t initialLength;
+            if (length < sizeof(initialLength)) return false;
+            std::memcpy(&initialLength, buffer, sizeof(initialLength));
+
+            // The layout of the rest of the header changed in DWARF 5
+            std::size_t lengthSize = initialLength == 0xffffffff ? 12 : 4;
+            std::uint16_t version;
+            if (length < lengthSize + sizeof(version)) return false;
+            std::memcpy(&version, buffer + lengthSize, sizeof(version));
+
+            unit_out.offset = offset;
+            bool success;
+            if (initialLength == 0xffffffff)
+            {
+                unit_out.width = DwarfWidth::Bits64;
+                success = version >= 5
+                    ? readUnitHeader<CompilationUnitHeader64v5, _detail::CompilationUnitHeader64v5>(buffer, length, lengthSize, unit_out)
+                    : readUnitHeader<CompilationUnitHeader64, _detail::CompilationUnitHeader64>(buffer, length, lengthSize, unit_out);
+            }
+            // Values 0xfffffff0 - 0xfffffffe are reserved
+            else if (initialLength < 0xfffffff0)
+            {
+                unit_out.width = DwarfWidth::Bits32;
+                success = version >= 5
+                    ? readUnitHeader<CompilationUnitHeader32v5, _detail::CompilationUnitHeader32v5>(buffer, length, lengthSize, unit_out)
+                    : readUnitHeader<CompilationUnitHeader32, _detail::CompilationUnitHeader32>(buffer, length, lengthSize, unit_out);
+            }
+            else return false;
+            if (!success) return false;
+
+            // Skeleton and split units carry a unit ID, and type units a signature and type offset
+            switch (unit_out.header->unitType())
+            {
+                case UnitType::Skeleton:
+                case UnitType::SplitCompile:
+                    unit_out.dieOffset += 8; break;
+                case UnitType::Type:
+                case UnitType::SplitType:
+                    unit_out.dieOffset += 8 + (unit_out.width == DwarfWidth::Bits64 ? 8 : 4); break;
+                default: break;
+            }
+            return unit_out.endOffset >= unit_out.dieOffset && unit_out.endOffset <= debug_info.size;
+        }
+
+
+        // Builds the DIE index of the given unit into its columns
+        static error_t indexUnit(const DwarfContext& context, const CompilationUnit& unit)
+        {
+            UnitIndexer indexer(context, unit);
+            if (parseDIEs(indexer, 0, 0) != 0) return -1;
+
+            unit.entries = std::move(indexer.entries);
+            return 0;
+        }
+
+
+        static error_t buildIndexes(DwarfContext& context, unsigned threadCount)
+        {
+            std::atomic<error_t> result{0};
+
+            // Index the DIEs of each unit not already indexed
+            context.workers.run(context.units.size(), threadCount, [&](std::size_t i) {
+                if (context.indexUnit(context.units[i]) != 0) result = -1;
+            });
+            return result;
+        }
+
+
+        static error_t buildNameIndex(DwarfContext& context, unsigned threadCount)
+        {
+            std::vector<std::vector<NamedEntry>> unitEntries(context.units.size());
+            std::atomic<error_t> result{0};
+
+            // Index each unit, then hash the names of its DIEs
+            context.workers.run(context.units.size(), threadCount, [&](std::size_t i)
+            {
+                auto& unit = context.units[i];
+                if (context.indexUnit(unit) != 0) { result = -1; return; }
+
+                for (std::uint32_t index = 0; index < unit.entries.size(); index++)
+                {
+                    auto* name = context.entryName(unit, index);
+                    if (name == nullptr) continue;
+
+                    std::string_view view(name);
+                    unitEntries[i].push_back(NamedEntry{ NameIndex::hash(view), name,
+                        static_cast<std::uint32_t>(view.size()), unit.entries.tags[index],
+                        makeDieId(unit.index, index) });
+                }
+            });
+            if (result != 0) return result;
+
+            context.nameIndex.build(unitEntries);
+            return 0;
+        }
+
+
+        // Reads the DWARF 5 offset table bases and DW_AT_low_pc/DW_AT_high_pc from the unit
+        // DIE, if present
+        static void readUnitAttributes(const DwarfContext& context, const CompilationUnit& unit)
+        {
+            auto& debug_info = context[SectionType::debug_info];
+            if (!debug_info || unit.abbreviations == nullptr) return;
 
+            const std::uint8_t* buffer = debug_info.data.get() + unit.dieOffset;
+            std::size_t length = unit.endOffset - unit.dieOffset;
 
-            // Parse abbreviation no.
             std::uint64_t abbrevId;
             auto size = uleb_read(buffer, length, abbrevId);
-			buffer += size; length -= size;
+            buffer += size; length -= size;
+
+            auto* abbrev = unit.abbreviations->find(abbrevId);
+            if (abbrev == nullptr) return;
+
+            // Without DW_AT_str_offsets_base, indices start after the table's header
+            if (unit.header->version() >= 5) unit.strOffsetsBase = unit.width == DwarfWidth::Bits64 ? 16 : 8;
 
-            // Get offset into abbreviation table
-            auto abbrev_offset = context.abbreviationIndex[abbrevId];
-			auto abbrevLength = debug_abbrev.size - abbrev_offset;
-			abbrevData += abbrev_offset;
-
-            // Skip abbreviation header
-			std::uint64_t _; std::uint32_t _1;
-			size = readHeader(abbrevData, abbrevLength, _, _1);
-			abbrevData += size; abbrevLength -= size;
-            abbrevData++;
-
-            // Count attributes
-            std::uint32_t attrCount = 0;
-            const std::uint8_t* tmpBuff = abbrevData;
-			auto tmpLength = abbrevLength;
-            while (true)
+            // The low PC may be an index into .debug_addr, so is resolved once the bases are known
+            Attribute lowPc, highPc;
+            bool hasLow = false, hasHigh = false;
+
+            for (auto& attr : *abbrev)
             {
-                std::uint32_t name, form;
+                std::size_t size = valueSize(attr, unit, buffer, length);
+                if (size == static_cast<std::size_t>(-1)) return;
 
-				auto size = dwarf::uleb_read(tmpBuff, tmpLength, name);
-				tmpBuff += size; tmpLength -= size;
+                auto value = makeAttribute(attr, buffer, size);
+                switch (attr.name)
+                {
+                    case AttributeName::LowPC:  lowPc = value; hasLow = true; break;
+                    case AttributeName::HighPC: highPc = value; hasHigh = true; break;
+                    case AttributeName::StrOffsetsBase: value.asSectionOffset(unit.strOffsetsBase); break;
+                    case AttributeName::AddrBase:       value.asSectionOffset(unit.addrBase); break;
+                    case AttributeName::RnglistsBase:   value.asSectionOffset(unit.rnglistsBase); break;
+                    case AttributeName::LoclistsBase:   value.asSectionOffset(unit.loclistsBase); break;
+                    default: break;
+                }
+                buffer += size; length -= size;
+            }
 
-                size = dwarf::uleb_read(tmpBuff, tmpLength, form);
-				tmpBuff += size; tmpLength -= size;
+            std::uint64_t low, high;
+            if (hasLow && hasHigh && context.attributeAddress(unit, lowPc, low))
+            {
+                // The high PC is either an address or an offset from the low PC
+                if (!context.attributeAddress(unit, highPc, high))
+                {
+                    if (!highPc.asUnsigned(high)) return;
+                    high += low;
+                }
 
-                if (name == 0 && form == 0) break;
-                else attrCount++;
+                unit.lowPc = low;
+                unit.highPc = high;
             }
+        }
 
-            // Create entry
-            DebugInfoEntry entry;
-            entry.id = id;
-            entry.abbreviationId = abbrevId;
-            entry.type = std::get<0>(index);
-            entry.attributeCount = attrCount;
-            entry.attributes = std::unique_ptr<Attribute[]>(new Attribute[attrCount]);
-
-            // Handle attributes
-            std::uint32_t attrIndex = 0;
-            while (true)
+
+        // Reads the address ranges of .debug_aranges, if present
+        static void readAddressRanges(const DwarfContext& context, std::vector<DwarfContext::UnitRange>& ranges_out)
+        {
+            auto& debug_aranges = context[SectionType::debug_aranges];
+            if (!debug_aranges) return;
+
+            const std::uint8_t* section = debug_aranges.data.get();
+            std::uint64_t offset = 0;
+
+            while (offset + 4 <= debug_aranges.size)
             {
-                // Read abbreviation attribute specifications
-                AttributeSpecification attr;
-                abbrevData += AttributeSpecification::parse(abbrevData,
-                    debug_abbrev.size - (abbrevData - origAbbrevData), attr);
+                // Read the set header, detecting 64-bit sets
+                std::uint32_t initialLength;
+                std::memcpy(&initialLength, section + offset, 4);
 
-                // Break upon NULL specification
-                if (attr.name == AttributeName::None &&
-                    attr.form == AttributeForm::None) break;
+                std::uint64_t unitLength = initialLength;
+                std::size_t lengthSize = 4, offsetSize = 4;
+                if (initialLength == 0xffffffff)
+                {
+                    if (offset + 12 > debug_aranges.size) break;
+                    std::memcpy(&unitLength, section + offset + 4, 8);
+                    lengthSize = 12; offsetSize = 8;
+                }
+                else if (initialLength >= 0xfffffff0) break;
 
-                // Get attribute size
-                std::size_t size = attributeSize(attr, context.unitHeader().addressSize(),
-                    context.width == DwarfWidth::Bits64 ? 8 : 4, buffer, length);
+                std::uint64_t setEnd = offset + lengthSize + unitLength;
+                std::uint64_t headerEnd = offset + lengthSize + 2 + offsetSize + 2;
+                if (setEnd > debug_aranges.size || headerEnd > setEnd) break;
 
-                // If invalid size, return early
-                if (size == static_cast<std::size_t>(-1)) return DebugInfoEntry();
+                std::uint64_t infoOffset = 0;
+                std::memcpy(&infoOffset, section + offset + lengthSize + 2, offsetSize);
+                std::uint8_t addressSize = section[headerEnd - 2];
+                std::uint8_t segmentSize = section[headerEnd - 1];
 
-                // Store attribute definition
-                entry.attributes[attrIndex++] = Attribute(attr, buffer, size);
+                // Find the unit the set describes
+                auto unit = std::lower_bound(context.units.begin(), context.units.end(), infoOffset,
+                    [](const CompilationUnit& unit, std::uint64_t offset) { return unit.offset < offset; });
 
-                // Advance buffer past value
-                buffer += size;
+                if (unit != context.units.end() && unit->offset == infoOffset &&
+                    addressSize != 0 && addressSize <= 8 && segmentSize == 0)
+                {
+                    // Tuples are aligned to twice the address size from the start of the set
+                    std::size_t tupleSize = 2 * addressSize;
+                    std::uint64_t tuple = offset + ((headerEnd - offset + tupleSize - 1) / tupleSize) * tupleSize;
+
+                    for (; tuple + tupleSize <= setEnd; tuple += tupleSize)
+                    {
+                        std::uint64_t address = 0, length = 0;
+                        std::memcpy(&address, section + tuple, addressSize);
+                        std::memcpy(&length, section + tuple + addressSize, addressSize);
+
+                        if (address == 0 && length == 0) break;
+                        if (length != 0) ranges_out.push_back({ address, address + length, unit->index });
+                    }
+                }
+                offset = setEnd;
+            }
+        }
+
+
+        // Loads the unit's abbreviation table, then the attributes of its unit DIE
+        static error_t prepareUnit(const DwarfContext& context, const CompilationUnit& unit)
+        {
+            auto& debug_abbrev = context[SectionType::debug_abbrev];
+            if (!debug_abbrev) return -1;
+
+            // Units whose table is corrupt or out of range are left without one
+            if (context.abbreviationCache.get(debug_abbrev.data.get(), debug_abbrev.size,
+                unit.header->debugAbbrevOffset(), unit.header->addressSize(),
+                unit.width == DwarfWidth::Bits64 ? 8 : 4, unit.abbreviations) != 0) return -1;
+
+            readUnitAttributes(context, unit);
+            return 0;
+        }
+
+
+        // Records the address ranges of each unit, preferring .debug_aranges and otherwise
+        // preparing the unit to read its DIE's DW_AT_low_pc/DW_AT_high_pc
+        static void readUnitRanges(const DwarfContext& context, std::vector<DwarfContext::UnitRange>& ranges_out)
+        {
+            readAddressRanges(context, ranges_out);
+
+            std::vector<bool> hasRanges(context.units.size());
+            for (auto& range : ranges_out) hasRanges[range.unit] = true;
+
+            for (auto& unit : context.units)
+            {
+                if (hasRanges[unit.index] || context.prepareUnit(unit) != 0) continue;
+                if (unit.lowPc < unit.highPc) ranges_out.push_back({ unit.lowPc, unit.highPc, unit.index });
             }
+            std::sort(ranges_out.begin(), ranges_out.end(),
+                [](const DwarfContext::UnitRange& a, const DwarfContext::UnitRange& b) { return a.low < b.low; });
+        }
+
+
+        static DebugInfoEntry dieFromId(std::uint64_t id, DwarfContext& context)
+        {
+            auto view = context.view(id);
+            if (!view) return DebugInfoEntry();
+
+            // Create entry
+            DebugInfoEntry entry;
+            entry.id = id;
+            entry.abbreviationId = view.abbreviation().code;
+            entry.type = view.tag();
+            entry.attributeCount = view.attributeCount();
+            entry.attributes = std::unique_ptr<Attribute[]>(new Attribute[entry.attributeCount]);
+
+            // Copy attributes, failing if any is malformed
+            std::size_t attrIndex = 0;
+            for (auto& attr : view) entry.attributes[attrIndex++] = attr;
+
+            if (attrIndex != entry.attributeCount) return DebugInfoEntry();
             return entry;
         }
     };
@@ -395,28 +860,467 @@ namespace dwarf
 	DwarfContext::DwarfContext(std::vector<DwarfSection>&& sections, DwarfWidth width) :
 		sections(std::move(sections)), width(width)
 	{
-		// Copy compilation unit header from debug_info section, if found
-		for (auto& section : this->sections) if (section.type == SectionType::debug_info)
+		dieIndex.context = this;
+
+		// Locate each compilation unit from the unit lengths in debug_info, if found
+		auto& debug_info = (*this)[SectionType::debug_info];
+		if (!debug_info) return;
+
+		std::vector<std::uint64_t> offsets;
+		for (std::uint64_t offset = 0; offset < debug_info.size; )
 		{
-			if (width == DwarfWidth::Bits32) {
-				CompilationUnitHeader32 header; std::memcpy(&header, section.data.get(), sizeof(header));
-				this->header.reset(new _detail::CompilationUnitHeader32(header));
-			}
-			else {
-				CompilationUnitHeader64 header; std::memcpy(&header, section.data.get(), sizeof(header));
-				this->header.reset(new _detail::CompilationUnitHeader64(header));
-			}
-			break;
+			CompilationUnit unit;
+			if (!DebugEntryParser::readUnitHeader(debug_info, offset, unit)) break;
+
+			offsets.push_back(offset);
+			offset = unit.endOffset;
 		}
+
+		// Units are constructed in place as they are not movable
+		units = std::vector<CompilationUnit>(offsets.size());
+		for (std::size_t i = 0; i < units.size(); i++)
+		{
+			DebugEntryParser::readUnitHeader(debug_info, offsets[i], units[i]);
+			units[i].index = static_cast<std::uint32_t>(i);
+		}
+
+		// Abbreviations, unit DIE attributes and address ranges are loaded on first use
 	}
 
 
-    error_t DwarfContext::buildIndexes()
+    error_t DwarfContext::buildIndexes(unsigned threadCount)
+    {
+        return DebugEntryParser::buildIndexes(*this, threadCount);
+    }
+
+
+    error_t DwarfContext::buildNameIndex(unsigned threadCount)
+    {
+        return DebugEntryParser::buildNameIndex(*this, threadCount);
+    }
+
+
+    std::vector<std::uint64_t> DwarfContext::lookupByName(std::string_view name, DIEType tag) const
+    {
+        // A name index adopted from a cache is only checked as it is used, so its ids may
+        // not refer to DIEs that exist
+        auto nameOf = [this](std::uint64_t id) -> const char* {
+            if (!isValidId(id)) return nullptr;
+            return entryName(unitOf(id), dieIdIndex(id));
+        };
+        std::vector<std::uint64_t> ids;
+        nameIndex.lookup(name, tag, nameOf, ids);
+
+        ids.erase(std::remove_if(ids.begin(), ids.end(),
+            [this](std::uint64_t id) { return !isValidId(id); }), ids.end());
+        return ids;
+    }
+
+
+    error_t DwarfContext::indexUnit(const CompilationUnit& unit) const
+    {
+        std::call_once(unit.indexOnce, [&]() {
+            // Prefer the cached index, unless it is corrupt
+            unit.indexResult = indexCache && adoptCachedIndex(unit) ? 0 :
+                DebugEntryParser::indexUnit(*this, unit);
+        });
+        return unit.indexResult;
+    }
+
+
+    error_t DwarfContext::prepareUnit(const CompilationUnit& unit) const
+    {
+        std::call_once(unit.prepareOnce, [&]() {
+            unit.prepareResult = DebugEntryParser::prepareUnit(*this, unit);
+        });
+        return unit.prepareResult;
+    }
+
+
+    const CompilationUnit* DwarfContext::unitForAddress(std::uint64_t address) const
+    {
+        std::call_once(rangesOnce, [this]() { DebugEntryParser::readUnitRanges(*this, unitRanges); });
+
+        // Find the last range starting at or before the address
+        auto it = std::upper_bound(unitRanges.begin(), unitRanges.end(), address,
+            [](std::uint64_t address, const UnitRange& range) { return address < range.low; });
+
+        if (it == unitRanges.begin() || address >= (it - 1)->high) return nullptr;
+        return &units[(it - 1)->unit];
+    }
+
+
+    bool DwarfContext::isValidId(std::uint64_t id) const
+    {
+        if (dieIdUnit(id) >= units.size()) return false;
+
+        auto& unit = units[dieIdUnit(id)];
+        return indexUnit(unit) == 0 && dieIdIndex(id) < unit.entries.size();
+    }
+
+
+    std::size_t DwarfContext::entryCount() const
+    {
+        // Reading a unit's entries is only safe once its index is complete, as in skipEmptyUnits
+        std::size_t count = 0;
+        for (auto& unit : units) {
+            if (indexUnit(unit) == 0) count += unit.entries.size();
+        }
+        return count;
+    }
+
+
+    const char* DwarfContext::entryName(const CompilationUnit& unit, std::uint32_t index) const
+    {
+        auto offset = unit.entries.names[index];
+        switch (unit.entries.nameSources[index])
+        {
+            case NameSource::Str:
+                return reinterpret_cast<const char*>((*this)[SectionType::debug_str].data.get() + offset);
+            case NameSource::LineStr:
+                return reinterpret_cast<const char*>((*this)[SectionType::debug_line_str].data.get() + offset);
+            case NameSource::Inline:
+                return reinterpret_cast<const char*>((*this)[SectionType::debug_info].data.get() + unit.offset + offset);
+            default:
+                return nullptr;
+        }
+    }
+
+
+    DieIndexEntry DwarfContext::entry(std::uint64_t id) const
+    {
+        auto& unit = unitOf(id);
+        auto index = dieIdIndex(id);
+        auto parent = unit.entries.parents[index];
+
+        return { id, unit.entries.tags[index],
+            parent != DieColumns::noParent ? makeDieId(dieIdUnit(id), parent) : noParent,
+            entryName(unit, index) };
+    }
+
+
+    std::uint64_t DwarfContext::firstChild(std::uint64_t id) const
+    {
+        auto& entries = unitOf(id).entries;
+        return entries.hasChildren(dieIdIndex(id)) ? id + 1 : noDie;
+    }
+
+    std::uint64_t DwarfContext::nextSibling(std::uint64_t id) const
+    {
+        auto sibling = unitOf(id).entries.nextSiblings[dieIdIndex(id)];
+        return sibling != DieColumns::noSibling ? makeDieId(dieIdUnit(id), sibling) : noDie;
+    }
+
+    std::uint64_t DwarfContext::subtreeEnd(std::uint64_t id) const
+    {
+        return makeDieId(dieIdUnit(id), unitOf(id).entries.subtreeEnds[dieIdIndex(id)]);
+    }
+
+
+    std::uint64_t DwarfContext::dieAtOffset(std::uint64_t offset) const
+    {
+        // Find the unit containing the offset
+        auto unit = std::upper_bound(units.begin(), units.end(), offset,
+            [](std::uint64_t offset, const CompilationUnit& unit) { return offset < unit.offset; });
+        if (unit == units.begin() || offset >= (--unit)->endOffset) return noDie;
+        if (indexUnit(*unit) != 0) return noDie;
+
+        // DIEs are indexed in offset order
+        auto& offsets = unit->entries.offsets;
+        auto relative = offset - unit->offset;
+        auto it = std::lower_bound(offsets.begin(), offsets.end(), relative);
+        if (it == offsets.end() || *it != relative) return noDie;
+
+        return makeDieId(unit->index, static_cast<std::uint32_t>(it - offsets.begin()));
+    }
+
+    std::uint64_t DwarfContext::referencedDie(const CompilationUnit& unit, const Attribute& attr) const
+    {
+        std::uint64_t offset;
+        return attr.asReference(unit.offset, offset) ? dieAtOffset(offset) : noDie;
+    }
+
+    const char* DwarfContext::attributeString(const CompilationUnit& unit, const Attribute& attr) const
+    {
+        std::uint64_t value;
+        if (attr.form == AttributeForm::LineStrp)
+        {
+            auto& debug_line_str = (*this)[SectionType::debug_line_str];
+            if (!attr.asSectionOffset(value) || value >= debug_line_str.size) return nullptr;
+            return reinterpret_cast<const char*>(debug_line_str.data.get() + value);
+        }
+        if (attr.class_ == AttributeClass::String && attr.asIndex(value)) return indexedString(unit, value);
+
+        auto& debug_str = (*this)[SectionType::debug_str];
+        const char* string;
+        return attr.asString(debug_str.data.get(), debug_str.size, string) ? string : nullptr;
+    }
+
+    bool DwarfContext::attributeAddress(const CompilationUnit& unit, const Attribute& attr,
+        std::uint64_t& address_out) const
+    {
+        if (attr.asAddress(address_out)) return true;
+
+        std::uint64_t index;
+        return attr.class_ == AttributeClass::Address && attr.asIndex(index) &&
+            indexedAddress(unit, index, address_out);
+    }
+
+
+    // Reads the entry of the given size at the given index of an offset table, if in bounds
+    static bool _readTableEntry(const DwarfSection& section, std::uint64_t base, std::uint64_t index,
+        std::size_t entrySize, std::uint64_t& value_out)
+    {
+        if (!section || entrySize == 0 || entrySize > sizeof(value_out) || base > section.size ||
+            index >= (section.size - base) / entrySize) return false;
+
+        value_out = 0;
+        std::memcpy(&value_out, section.data.get() + base + index * entrySize, entrySize);
+        return true;
+    }
+
+    const char* DwarfContext::indexedString(const CompilationUnit& unit, std::uint64_t index) const
+    {
+        std::uint64_t offset;
+        auto& debug_str = (*this)[SectionType::debug_str];
+        if (!_readTableEntry((*this)[SectionType::debug_str_offsets], unit.strOffsetsBase, index,
+            unit.width == DwarfWidth::Bits64 ? 8 : 4, offset) || offset >= debug_str.size) return nullptr;
+
+        return reinterpret_cast<const char*>(debug_str.data.get() + offset);
+    }
+
+    bool DwarfContext::indexedAddress(const CompilationUnit& unit, std::uint64_t index, std::uint64_t& address_out) const
+    {
+        return _readTableEntry((*this)[SectionType::debug_addr], unit.addrBase, index,
+            unit.header->addressSize(), address_out);
+    }
+
+    bool DwarfContext::rangeListOffset(const CompilationUnit& unit, std::uint64_t index, std::uint64_t& offset_out) const
+    {
+        // Offsets in the table are relative to its start
+        if (!_readTableEntry((*this)[SectionType::debug_rnglists], unit.rnglistsBase, index,
+            unit.width == DwarfWidth::Bits64 ? 8 : 4, offset_out)) return false;
+
+        offset_out += unit.rnglistsBase;
+        return true;
+    }
+
+    bool DwarfContext::locationListOffset(const CompilationUnit& unit, std::uint64_t index, std::uint64_t& offset_out) const
+    {
+        if (!_readTableEntry((*this)[SectionType::debug_loclists], unit.loclistsBase, index,
+            unit.width == DwarfWidth::Bits64 ? 8 : 4, offset_out)) return false;
+
+        offset_out += unit.loclistsBase;
+        return true;
+    }
+
+
+    UnitIndexer::UnitIndexer(const DwarfContext& context, const CompilationUnit& unit)
+        : context(&context), unit(&unit), offset(unit.dieOffset)
+    {
+        // Without the unit's data there is nothing to parse. Offsets in the index are 32-bit
+        // and relative to the unit, so larger (DWARF64) units cannot be indexed.
+        auto& debug_info = context[SectionType::debug_info];
+        failed = !debug_info || unit.endOffset - unit.offset > static_cast<std::uint32_t>(-1) ||
+            context.prepareUnit(unit) != 0;
+        scopes.push_back({ DieColumns::noParent, DieColumns::noSibling });
+    }
+
+    error_t UnitIndexer::resume(std::size_t byteBudget, std::size_t dieBudget)
+    {
+        if (DebugEntryParser::parseDIEs(*this, byteBudget, dieBudget) != 0) return -1;
+
+        // Install the completed index unless the unit has been indexed already
+        if (finished())
+        {
+            std::call_once(unit->indexOnce, [this]() {
+                unit->entries = std::move(entries);
+                unit->indexResult = 0;
+            });
+        }
+        return 0;
+    }
+
+
+    DieView DwarfContext::view(std::uint64_t id) const
+    {
+        DieView view;
+        if (!isValidId(id)) return view;
+
+        auto& unit = unitOf(id);
+        if (prepareUnit(unit) != 0) return view;
+        auto offset = unit.offset + unit.entries.offsets[dieIdIndex(id)];
+        const std::uint8_t* buffer = (*this)[SectionType::debug_info].data.get() + offset;
+        std::size_t length = unit.endOffset - offset;
+
+        // Parse abbreviation no.
+        std::uint64_t abbrevId;
+        auto size = uleb_read(buffer, length, abbrevId);
+
+        view.abbrev = unit.abbreviations->find(abbrevId);
+        if (view.abbrev == nullptr) return view;
+
+        view.unit = &unit;
+        view.values = buffer + size;
+        view.length = length - size;
+        view._id = id;
+        return view;
+    }
+
+
+    bool DieView::attribute(AttributeName name, Attribute& attribute_out) const noexcept
+    {
+        if (abbrev == nullptr) return false;
+
+        for (std::uint32_t i = 0; i < abbrev->attributeCount; i++)
+        {
+            auto& attr = abbrev->attributes[i];
+            if (attr.name != name) continue;
+
+            // The value follows the fixed-size values before it plus any variable-size ones
+            std::size_t variableBytes = 0;
+            for (std::uint32_t j = 0; j < i; j++)
+            {
+                auto& prior = abbrev->attributes[j];
+                if (prior.isFixedSize()) continue;
+
+                std::size_t offset = prior.fixedOffset + variableBytes;
+                if (offset > length) return false;
+
+                const std::uint8_t* value = values + offset;
+                std::size_t remaining = length - offset;
+                auto size = DebugEntryParser::valueSize(prior, *unit, value, remaining);
+                if (size == static_cast<std::size_t>(-1)) return false;
+
+                variableBytes += (value - (values + offset)) + size;
+            }
+
+            std::size_t offset = attr.fixedOffset + variableBytes;
+            if (offset > length) return false;
+
+            const std::uint8_t* value = values + offset;
+            std::size_t remaining = length - offset;
+            auto size = DebugEntryParser::valueSize(attr, *unit, value, remaining);
+            if (size == static_cast<std::size_t>(-1)) return false;
+
+            attribute_out = DebugEntryParser::makeAttribute(attr, value, size);
+            return true;
+        }
+        return false;
+    }
+
+    DieAttributeIterator DieView::begin() const noexcept
+    {
+        if (abbrev == nullptr) return DieAttributeIterator();
+        return DieAttributeIterator(unit, abbrev->begin(), abbrev->end(), values, length);
+    }
+
+    DieAttributeIterator DieView::end() const noexcept
+    {
+        if (abbrev == nullptr) return DieAttributeIterator();
+        return DieAttributeIterator(unit, abbrev->end(), abbrev->end(), nullptr, 0);
+    }
+
+    error_t DieView::materialize(DieArena& arena, const Attribute*& attributes_out) const noexcept
+    {
+        if (abbrev == nullptr) return -1;
+
+        auto* attributes = arena.allocate<Attribute>(abbrev->attributeCount);
+        if (attributes == nullptr) return -1;
+
+        std::size_t count = 0;
+        for (auto& attr : *this) attributes[count++] = attr;
+        if (count != abbrev->attributeCount) return -1;
+
+        attributes_out = attributes;
+        return 0;
+    }
+
+
+    DieAttributeIterator::DieAttributeIterator(const CompilationUnit* unit, const AbbreviationAttribute* spec,
+        const AbbreviationAttribute* specEnd, const std::uint8_t* value, std::size_t length) noexcept
+        : unit(unit), spec(spec), specEnd(specEnd), length(length)
+    {
+        decode(value);
+    }
+
+    DieAttributeIterator& DieAttributeIterator::operator++() noexcept
+    {
+        spec++;
+        decode(next);
+        return *this;
+    }
+
+    void DieAttributeIterator::decode(const std::uint8_t* value) noexcept
+    {
+        if (spec == specEnd) return;
+
+        auto size = DebugEntryParser::valueSize(*spec, *unit, value, length);
+        if (size == static_cast<std::size_t>(-1)) { spec = specEnd; return; }
+
+        current = DebugEntryParser::makeAttribute(*spec, value, size);
+        next = value + size;
+        length -= size;
+    }
+
+
+    DieSiblingIterator& DieSiblingIterator::operator++()
+    {
+        id = context->nextSibling(id);
+        return *this;
+    }
+
+    DieIndexEntry DieSiblingIterator::operator*() const
+    {
+        return context->entry(id);
+    }
+
+
+    void DieIndexIterator::skipEmptyUnits()
+    {
+        // Units are indexed as the iteration reaches them, if not already
+        auto& units = context->compilationUnits();
+        while (unit < units.size() && (context->indexUnit(units[unit]) != 0 || index >= units[unit].entries.size())) {
+            unit++; index = 0;
+        }
+    }
+
+    DieIndexIterator& DieIndexIterator::operator++()
+    {
+        index++;
+        skipEmptyUnits();
+        return *this;
+    }
+
+    DieIndexEntry DieIndexIterator::operator*() const
+    {
+        return context->entry(makeDieId(unit, index));
+    }
+
+
+    DieIndexIterator DieIndexIteratorProxy::begin() const
+    {
+        DieIndexIterator it(context, 0, 0);
+        it.skipEmptyUnits();
+        return it;
+    }
+
+    DieIndexIterator DieIndexIteratorProxy::end() const
+    {
+        return DieIndexIterator(context, static_cast<std::uint32_t>(context->compilationUnits().size()), 0);
+    }
+
+
+    error_t DwarfContext::unitEntries(const CompilationUnit& unit, TraversalMode mode,
+        std::vector<DieLocation>& entries_out, DIEType tag) const
+    {
+        return DebugEntryParser::traverse(*this, unit, mode, tag, entries_out);
+    }
+
+
+    error_t DwarfContext::subprograms(const CompilationUnit& unit, std::vector<DieLocation>& entries_out) const
     {
-        auto res = DebugEntryParser::buildIndexes(*this);
-        dieIndex._begin = entryIndex.cbegin();
-        dieIndex._end = entryIndex.cend();
-        return res;
+        return DebugEntryParser::traverse(*this, unit, TraversalMode::TopLevel, DIEType::Subprogram, entries_out);
     }
 
 
@@ -4,33 +4,24 @@
 #include <cstdint>
 #include <string.h>
 #include <memory>
+#include <mutex>
 #include <array>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 #include <unordered_map>
+#include "abbrev.hpp"
+#include "column.hpp"
 #include "const.hpp"
 #include "format.hpp"
+#include "names.hpp"
+#include "workers.hpp"
 
 namespace dwarf
 {
     typedef signed long int error_t;
 
 
-	/* Reads an unsigned LEB value from the given buffer of the specified length.
-	   Returns the number of bytes read. */
-	std::uint32_t uleb_read(const std::uint8_t data[], std::size_t length, std::uint32_t &value_out);
-	/* Reads an unsigned LEB value from the given buffer of the specified length.
-	   Returns the number of bytes read. */
-    std::uint32_t uleb_read(const std::uint8_t data[], std::size_t length, std::uint64_t &value_out);
-
-	/* Reads a signed LEB value from the given buffer of the specified length.
-	   Returns the number of bytes read. */
-    std::uint32_t sleb_read(const std::uint8_t data[], std::size_t length, std::int32_t &value_out);
-	/* Reads a signed LEB value from the given buffer of the specified length.
-	   Returns the number of bytes read. */
-    std::uint32_t sleb_read(const std::uint8_t data[], std::size_t length, std::int64_t &value_out);
-
-
-
     enum class SectionType : std::uint8_t
     {
         invalid,
@@ -39,19 +30,79 @@ namespace dwarf
         debug_aranges,
         debug_ranges,
         debug_line,
-        debug_str
+        debug_str,
+        // DWARF 5
+        debug_str_offsets,
+        debug_addr,
+        debug_rnglists,
+        debug_loclists,
+        debug_line_str
     };
 
 
+    /* Gets the type of the section with the given name. Legacy GNU compressed
+       section names (.zdebug_*) map to the same types as their .debug_* forms. */
     SectionType SectionTypeFromString(const char* str);
 
+    /* Gets the (uncompressed) name of the given section type, e.g. ".debug_info". */
+    const char* SectionTypeToString(SectionType type);
+
+
+
+    /* Pointer to section data which either owns it or borrows it, e.g. from a
+       memory-mapped file. */
+    class SectionData
+    {
+    private:
+        const std::uint8_t* data{};
+        bool owner{};
+
+    public:
+        SectionData() = default;
+        inline SectionData(std::unique_ptr<std::uint8_t[]> data) noexcept
+            : data(data.release()), owner(true) { }
+
+        inline ~SectionData() {
+            reset();
+        }
+
+        SectionData(const SectionData&) = delete;
+        SectionData& operator=(const SectionData&) = delete;
+
+        inline SectionData(SectionData&& other) noexcept : data(other.data), owner(other.owner) {
+            other.data = nullptr; other.owner = false;
+        }
+        inline SectionData& operator=(SectionData&& other) noexcept
+        {
+            if (this != &other) {
+                reset(other.data, other.owner);
+                other.data = nullptr; other.owner = false;
+            }
+            return *this;
+        }
+
+    public:
+        inline const std::uint8_t* get() const noexcept {
+            return data;
+        }
+        inline bool ownsData() const noexcept {
+            return owner;
+        }
+        inline void reset(const std::uint8_t* data = nullptr, bool owner = false) noexcept
+        {
+            if (this->owner) delete[] this->data;
+            this->data = data; this->owner = owner;
+        }
+    };
+
 
 
     struct DwarfSection
     {
         SectionType type = SectionType::invalid;
-        std::unique_ptr<std::uint8_t[]> data{};
+        SectionData data{};
         std::uint64_t size{};
+        std::uint64_t fileOffset{}; // Offset of the section within its file, if loaded from one
 
     public:
         DwarfSection() = default;
@@ -59,6 +110,13 @@ namespace dwarf
         inline DwarfSection(SectionType type, std::unique_ptr<std::uint8_t[]> data, std::uint64_t size) noexcept
             : type(type), data(std::move(data)), size(size) { }
 
+        /* Creates a section borrowing the given data, which must outlive it. */
+        inline DwarfSection(SectionType type, const std::uint8_t* data, std::uint64_t size) noexcept
+            : type(type), size(size) { this->data.reset(data, false); }
+
+        DwarfSection(DwarfSection&&) = default;
+        DwarfSection& operator=(DwarfSection&&) = default;
+
         explicit DwarfSection(const DwarfSection& other);
         DwarfSection& operator=(const DwarfSection& other);
 
@@ -69,6 +127,23 @@ namespace dwarf
 
 
 
+    /* Parent id of DIEs at the top level of their compilation unit. */
+    constexpr std::uint64_t noParent = static_cast<std::uint64_t>(-1);
+    /* Id standing for no DIE, e.g. the next sibling of a last child. */
+    constexpr std::uint64_t noDie = static_cast<std::uint64_t>(-1);
+
+    /* DIE ids hold the index of the DIE's compilation unit in the upper 32 bits and the
+       position of the DIE within the unit's index in the lower 32 bits. */
+    inline constexpr std::uint64_t makeDieId(std::uint32_t unit, std::uint32_t index) noexcept {
+        return (static_cast<std::uint64_t>(unit) << 32) | index;
+    }
+    inline constexpr std::uint32_t dieIdUnit(std::uint64_t id) noexcept {
+        return static_cast<std::uint32_t>(id >> 32);
+    }
+    inline constexpr std::uint32_t dieIdIndex(std::uint64_t id) noexcept {
+        return static_cast<std::uint32_t>(id);
+    }
+
     struct DieIndexEntry
     {
         std::uint64_t id;
@@ -77,47 +152,128 @@ namespace dwarf
         const char* name;
     };
 
-    template<typename Iter>
-    struct DieIndexIterator
+
+    /* The string section holding a DIE's name in the DIE index. */
+    enum class NameSource : std::uint8_t
     {
-        Iter iter{};
-        std::uint64_t index{};
+        None,    // The DIE has no name, or its offset does not fit in 32 bits
+        Str,     // .debug_str
+        LineStr, // .debug_line_str
+        Inline   // An inline string (DW_FORM_string), relative to the start of the unit
+    };
 
-        DieIndexIterator() = default;
-        inline DieIndexIterator(const Iter& iter) : iter(iter) { }
+
+    /* The DIE index of one compilation unit, held as one array per field (~23 bytes per DIE).
+       The arrays are built by UnitIndexer or borrowed from a mapped index cache.
+       Positions within the unit are 32-bit, as are offsets, which are relative to the unit;
+       units larger than 4 GiB (only possible in DWARF64) are not indexed.
+       DIEs are in depth-first order, so a DIE's descendants follow it directly: its first
+       child (if any) is the next DIE, and its subtree ends at subtreeEnds. */
+    struct DieColumns
+    {
+        static constexpr std::uint32_t noParent = static_cast<std::uint32_t>(-1);
+        static constexpr std::uint32_t noSibling = static_cast<std::uint32_t>(-1);
+
+        Column<DIEType> tags{};
+        Column<NameSource> nameSources{};
+        Column<std::uint32_t> parents{}; // Position of the parent DIE, or noParent
+        Column<std::uint32_t> names{};   // Offset of the name within its source
+        Column<std::uint32_t> offsets{}; // Offset of the DIE from the start of the unit
+
+        Column<std::uint32_t> nextSiblings{}; // Position of the next sibling, or noSibling
+        Column<std::uint32_t> subtreeEnds{};  // Position one past the DIE's last descendant
+
+        // Number of DIEs left unnamed because their name's offset does not fit in 32 bits
+        std::uint32_t droppedNames{};
 
     public:
-        inline bool operator !=(const DieIndexIterator& other) {
-            return iter != other.iter;
+        inline std::size_t size() const noexcept {
+            return tags.size();
+        }
+        inline bool hasChildren(std::uint32_t index) const noexcept {
+            return subtreeEnds[index] > index + 1;
         }
-        inline bool operator ==(const DieIndexIterator& other) {
-            return iter == other.iter;
+        inline void clear() noexcept
+        {
+            tags.clear(); nameSources.clear(); parents.clear(); names.clear(); offsets.clear();
+            nextSiblings.clear(); subtreeEnds.clear(); droppedNames = 0;
         }
+    };
+
+
+    class DwarfContext;
 
-        inline auto& operator++() {
-            iter++; index++; return *this;
+    struct DieIndexIterator
+    {
+        const DwarfContext* context{};
+        std::uint32_t unit{};
+        std::uint32_t index{};
+
+        DieIndexIterator() = default;
+        inline DieIndexIterator(const DwarfContext* context, std::uint32_t unit, std::uint32_t index)
+            : context(context), unit(unit), index(index) { }
+
+    public:
+        inline bool operator !=(const DieIndexIterator& other) const {
+            return unit != other.unit || index != other.index;
         }
-        inline DieIndexEntry operator*() {
-            return { index, std::get<0>(*iter), std::get<1>(*iter), std::get<2>(*iter) };
+        inline bool operator ==(const DieIndexIterator& other) const {
+            return unit == other.unit && index == other.index;
         }
+
+        DieIndexIterator& operator++();
+        DieIndexEntry operator*() const;
+
+    private:
+        friend struct DieIndexIteratorProxy;
+        void skipEmptyUnits();
     };
 
-    template<typename BeginIter, typename EndIter>
     struct DieIndexIteratorProxy
     {
         friend class DwarfContext;
-        friend class DwarfContext;
 
     private:
-        BeginIter _begin;
-        EndIter _end;
+        const DwarfContext* context{};
+
+    public:
+        DieIndexIterator begin() const;
+        DieIndexIterator end() const;
+    };
+
+
+    /* Iterates a chain of sibling DIEs via their next-sibling links. */
+    struct DieSiblingIterator
+    {
+        const DwarfContext* context{};
+        std::uint64_t id = noDie;
+
+        DieSiblingIterator() = default;
+        inline DieSiblingIterator(const DwarfContext* context, std::uint64_t id)
+            : context(context), id(id) { }
+
+    public:
+        inline bool operator !=(const DieSiblingIterator& other) const {
+            return id != other.id;
+        }
+        inline bool operator ==(const DieSiblingIterator& other) const {
+            return id == other.id;
+        }
+
+        DieSiblingIterator& operator++();
+        DieIndexEntry operator*() const;
+    };
+
+    struct DieSiblingRange
+    {
+        DieSiblingIterator first{};
 
     public:
-        inline DieIndexIterator<BeginIter> begin() {
-            return _begin;
+        inline DieSiblingIterator begin() const {
+            return first;
         }
-        inline DieIndexIterator<EndIter> end() {
-            return _end;
+        inline DieSiblingIterator end() const {
+            return DieSiblingIterator(first.context, noDie);
         }
     };
 
@@ -130,40 +286,431 @@ namespace dwarf
 
 
 
+    /* A compilation unit within .debug_info, located by pre-scanning unit lengths. Together
+       the units form a directory of .debug_info built when the context is created; each
+       unit's abbreviations, unit DIE attributes and DIE index are loaded separately, either
+       up front or on first use. */
+    struct CompilationUnit
+    {
+        std::uint32_t index{};     // Position of the unit in the context's directory
+        std::uint64_t offset{};    // Offset of the unit header within .debug_info
+        std::uint64_t dieOffset{}; // Offset of the unit's first DIE
+        std::uint64_t endOffset{}; // Offset one past the end of the unit
+        DwarfWidth width{};
+        std::unique_ptr<CompilationUnitHeader> header{};
+
+        // The following are loaded when the unit is prepared (see DwarfContext::prepareUnit)
+
+        // The unit's abbreviation table, shared with other units at the same offset. nullptr
+        // if the table could not be parsed, in which case the unit cannot be indexed.
+        mutable const AbbreviationTable* abbreviations{};
+
+        // Range of code addresses [lowPc, highPc) of the unit's DIE, if known
+        mutable std::uint64_t lowPc{};
+        mutable std::uint64_t highPc{};
+
+        // Offsets of the unit's contributions to the DWARF 5 offset tables, from the unit DIE
+        mutable std::uint64_t strOffsetsBase{}; // Within .debug_str_offsets
+        mutable std::uint64_t addrBase{};       // Within .debug_addr
+        mutable std::uint64_t rnglistsBase{};   // Within .debug_rnglists
+        mutable std::uint64_t loclistsBase{};   // Within .debug_loclists
+
+        // Index of the unit's DIEs. Empty until the unit is indexed (see DwarfContext::indexUnit)
+        mutable DieColumns entries{};
+
+    private:
+        friend class DwarfContext;
+        friend class IndexCache;
+        friend class UnitIndexer;
+        mutable std::once_flag prepareOnce{};
+        mutable error_t prepareResult{};
+        mutable std::once_flag indexOnce{};
+        mutable error_t indexResult{};
+    };
+
+
+    /* Builds the DIE index of one compilation unit incrementally, so that indexing can be
+       spread over time slices. Nesting is tracked on an explicit stack rather than the call
+       stack, so deeply nested DIEs need no more thread stack than shallow ones.
+
+       Each call to resume() parses until the unit is complete or a budget runs out, and
+       may be followed by further calls to continue. Once complete, the index is installed
+       as the unit's own unless the unit was indexed in the meantime. */
+    class UnitIndexer
+    {
+        friend class DebugEntryParser;
+
+    private:
+        // A chain of sibling DIEs being parsed
+        struct Scope
+        {
+            std::uint32_t parent;   // Position of the parent DIE, or noParent
+            std::uint32_t previous; // Position of the last DIE parsed in the chain, or noSibling
+        };
+
+        const DwarfContext* context{};
+        const CompilationUnit* unit{};
+        DieColumns entries{};
+        std::uint64_t offset{};      // Offset of the next DIE within .debug_info
+        std::vector<Scope> scopes{}; // Open chains, innermost last
+        bool failed{};
+
+    public:
+        UnitIndexer(const DwarfContext& context, const CompilationUnit& unit);
+
+        /* Parses DIEs until the unit is complete or either budget is exhausted. A budget
+           of 0 is unlimited; at least one DIE is parsed per call. Returns -1 upon error. */
+        error_t resume(std::size_t byteBudget = 0, std::size_t dieBudget = 0);
+
+        inline bool finished() const noexcept {
+            return scopes.empty();
+        }
+        /* Gets the number of DIEs parsed so far. */
+        inline std::size_t entryCount() const noexcept {
+            return entries.size();
+        }
+        inline const CompilationUnit& compilationUnit() const noexcept {
+            return *unit;
+        }
+    };
+
+
+    /* How a traversal of a unit's DIEs proceeds. */
+    enum class TraversalMode
+    {
+        All,      // Visit every DIE, descending into all children
+        TopLevel  // Visit the unit DIE and its children only, jumping over each child's
+                  // subtree via DW_AT_sibling where present
+    };
+
+    /* A DIE found by traversing a unit, without reference to the DIE index. */
+    struct DieLocation
+    {
+        std::uint64_t offset;  // Offset of the DIE within .debug_info
+        DIEType type;
+        std::size_t depth;     // 0 for the unit DIE
+        const char* name;
+        bool hasChildren;
+    };
+
+
+    /* Bump allocator over a caller-supplied buffer, for materialising DIEs without touching
+       the heap. Allocations are released all at once by reset(). */
+    class DieArena
+    {
+    private:
+        std::uint8_t* buffer{};
+        std::size_t capacity{};
+        std::size_t used{};
+
+    public:
+        DieArena() = default;
+        inline DieArena(void* buffer, std::size_t size) noexcept
+            : buffer(static_cast<std::uint8_t*>(buffer)), capacity(size) { }
+
+        /* Allocates 'count' default-constructed objects, or returns nullptr if the
+           buffer is exhausted. */
+        template<typename T>
+        inline T* allocate(std::size_t count) noexcept
+        {
+            static_assert(std::is_trivially_destructible<T>::value, "");
+
+            auto address = reinterpret_cast<std::uintptr_t>(buffer) + used;
+            std::size_t padding = (alignof(T) - address % alignof(T)) % alignof(T);
+            if (padding > capacity - used || count > (capacity - used - padding) / sizeof(T)) {
+                return nullptr;
+            }
+            T* objects = reinterpret_cast<T*>(buffer + used + padding);
+            for (std::size_t i = 0; i < count; i++) new (objects + i) T();
+
+            used += padding + count * sizeof(T);
+            return objects;
+        }
+
+        inline void reset() noexcept {
+            used = 0;
+        }
+        inline std::size_t bytesUsed() const noexcept {
+            return used;
+        }
+    };
+
+
+    /* Iterates the attributes of a DIE, decoding each value as it is reached. Stops early
+       if a value is malformed. */
+    class DieAttributeIterator
+    {
+    private:
+        const CompilationUnit* unit{};
+        const AbbreviationAttribute* spec{};
+        const AbbreviationAttribute* specEnd{};
+        const std::uint8_t* next{}; // Start of the following value
+        std::size_t length{};       // Bytes remaining in the unit from 'next'
+        Attribute current{};
+
+    public:
+        DieAttributeIterator() = default;
+        DieAttributeIterator(const CompilationUnit* unit, const AbbreviationAttribute* spec,
+            const AbbreviationAttribute* specEnd, const std::uint8_t* value, std::size_t length) noexcept;
+
+    public:
+        inline bool operator !=(const DieAttributeIterator& other) const noexcept {
+            return spec != other.spec;
+        }
+        inline bool operator ==(const DieAttributeIterator& other) const noexcept {
+            return spec == other.spec;
+        }
+        inline const Attribute& operator*() const noexcept {
+            return current;
+        }
+        inline const Attribute* operator->() const noexcept {
+            return &current;
+        }
+        DieAttributeIterator& operator++() noexcept;
+
+    private:
+        void decode(const std::uint8_t* value) noexcept;
+    };
+
+
+    /* A lightweight view of one DIE over the mapped .debug_info data, suitable for the stack.
+       Nothing is decoded up front: attribute values are located and decoded on access, and
+       no operation on a view allocates. Views remain valid as long as their context. */
+    class DieView
+    {
+        friend class DwarfContext;
+
+    private:
+        const CompilationUnit* unit{};
+        const Abbreviation* abbrev{};
+        const std::uint8_t* values{}; // Start of the DIE's attribute values
+        std::size_t length{};         // Bytes from 'values' to the end of the unit
+        std::uint64_t _id = noDie;
+
+    public:
+        DieView() = default;
+
+        inline explicit operator bool() const noexcept {
+            return abbrev != nullptr;
+        }
+        inline std::uint64_t id() const noexcept {
+            return _id;
+        }
+        inline DIEType tag() const noexcept {
+            return abbrev->tag;
+        }
+        inline bool hasChildren() const noexcept {
+            return abbrev->hasChildren;
+        }
+        inline std::size_t attributeCount() const noexcept {
+            return abbrev->attributeCount;
+        }
+        inline const CompilationUnit& compilationUnit() const noexcept {
+            return *unit;
+        }
+        inline const Abbreviation& abbreviation() const noexcept {
+            return *abbrev;
+        }
+
+        /* Finds the attribute with the given name, decoding only the variable-size values
+           that precede it. Returns false if the DIE has no such attribute. */
+        bool attribute(AttributeName name, Attribute& attribute_out) const noexcept;
+
+        inline bool hasAttribute(AttributeName name) const noexcept
+        {
+            for (auto& attr : *abbrev) if (attr.name == name) return true;
+            return false;
+        }
+
+        DieAttributeIterator begin() const noexcept;
+        DieAttributeIterator end() const noexcept;
+
+        /* Decodes every attribute into an array allocated from the given arena. Returns -1
+           if the arena is exhausted or the DIE is malformed. */
+        error_t materialize(DieArena& arena, const Attribute*& attributes_out) const noexcept;
+    };
+
+
     class DwarfContext
     {
         friend class DebugEntryParser;
+        friend class IndexCache;
 
 
     private:
-        std::unique_ptr<CompilationUnitHeader> header{};
+        std::vector<CompilationUnit> units{};
+        mutable AbbreviationCache abbreviationCache{};
+
+        // Address ranges of the units, sorted by start address
+        struct UnitRange
+        {
+            std::uint64_t low;
+            std::uint64_t high;
+            std::uint32_t unit;
+        };
+        mutable std::vector<UnitRange> unitRanges{};
+        mutable std::once_flag rangesOnce{}; // Ranges are gathered on first use
+
+        // Optional index of DIEs by name, built by buildNameIndex
+        NameIndex nameIndex{};
 
-        using EntryIndex = std::tuple<DIEType, std::uint64_t, const char*, std::size_t>;
-        std::unordered_map<std::uint64_t, std::size_t> abbreviationIndex{};
-        std::vector<EntryIndex> entryIndex{};
+        // Mapped index cache file, if loaded, from which index columns are borrowed
+        std::shared_ptr<const std::uint8_t> indexCache{};
+
+        // Threads for building indexes, kept between builds
+        WorkerPool workers{};
+
+        // Adopts the unit's columns from the index cache if they are valid (see cache.cpp)
+        bool adoptCachedIndex(const CompilationUnit& unit) const;
 
     public:
         const std::vector<DwarfSection> sections{0};
 
 		const DwarfWidth width{};
 
-        DieIndexIteratorProxy<decltype(entryIndex.cbegin()),
-            decltype(entryIndex.cend())> dieIndex{};
+        /* Iterates every indexed DIE in .debug_info order. */
+        DieIndexIteratorProxy dieIndex{};
 
     public:
 		explicit DwarfContext(std::vector<DwarfSection>&& sections, DwarfWidth width);
 
     public:
 
-        error_t buildIndexes();
-
+        /* Indexes the DIEs of every compilation unit. Units are indexed concurrently on
+           the given number of threads (by default, one per core), which the context keeps
+           for later builds.
+
+           Calling this is optional: without it, the context indexes each unit the first time
+           one of its DIEs is queried, so only the units actually used are ever parsed. */
+        error_t buildIndexes(unsigned threadCount = 0);
+
+        /* Builds the DIE index of the given unit if it has not been built already, adopting
+           it from the index cache if one is loaded. Safe to call concurrently; each unit is
+           indexed at most once. */
+        error_t indexUnit(const CompilationUnit& unit) const;
+
+        /* Loads the given unit's abbreviation table and the attributes of its unit DIE if
+           not already loaded. Safe to call concurrently; each unit is prepared at most once.
+           Units are prepared as their DIEs are first parsed, so a unit whose index comes
+           from a cache is never prepared unless its DIEs are read. */
+        error_t prepareUnit(const CompilationUnit& unit) const;
+
+        /* Indexes every unit (as buildIndexes) and builds a hash index of DIEs by name,
+           for lookupByName. */
+        error_t buildNameIndex(unsigned threadCount = 0);
+
+        /* Writes the DIE index of every unit (indexing units as needed) and the name index,
+           if built, to a cache file at the given path. The cache is keyed by the given
+           build-ID and the file offset and size of each of the context's sections. */
+        error_t saveIndexCache(const char* path, const std::uint8_t* buildId, std::size_t buildIdSize) const;
+
+        /* Maps a cache file written by saveIndexCache and adopts its indexes in place of
+           building them. Only the file's header and layout are checked on loading; each
+           unit's columns are checked when the unit is first used, and the unit is parsed as
+           normal if they are corrupt. Nothing else is parsed, copied or hashed unless
+           'verifyContents' is set, in which case the file's checksum and a hash of the
+           contents of the sections are checked as well. Units already indexed keep their
+           own index. Returns -1 if the file is missing, corrupt, of another version or keyed
+           to another build-ID or section layout, or if a cache has already been loaded. */
+        error_t loadIndexCache(const char* path, const std::uint8_t* buildId, std::size_t buildIdSize,
+            bool verifyContents = false);
+
+        /* Gets the ids of the DIEs with the given name and, unless DIEType::None, the given
+           tag, in .debug_info order. Runs in O(1) expected time plus the number of DIEs
+           with the name. Finds nothing unless buildNameIndex has been called. */
+        std::vector<std::uint64_t> lookupByName(std::string_view name, DIEType tag = DIEType::None) const;
+
+        /* Gets the total number of DIEs, indexing units as necessary. Units that cannot be
+           indexed are not counted. */
+        std::size_t entryCount() const;
+
+        /* Materialises the DIE with the given id, copying its attributes to the heap.
+           Prefer view() where the entry need not outlive the call. */
         DebugInfoEntry dieFromId(std::uint64_t id);
 
+        /* Gets an allocation-free view of the DIE with the given id, or an empty view if
+           the id is not valid. */
+        DieView view(std::uint64_t id) const;
+
         const DwarfSection& operator[](SectionType type) const;
 
+        /* Gets the compilation units of .debug_info, in section order. */
+        inline const std::vector<CompilationUnit>& compilationUnits() const {
+            return units;
+        }
+
+        /* Lists the DIEs of the given unit (optionally only those with the given tag) by reading
+           .debug_info directly. Does not require or use the DIE index. In TraversalMode::TopLevel
+           the cost is proportional to the number of top-level DIEs where producers emit
+           DW_AT_sibling. */
+        error_t unitEntries(const CompilationUnit& unit, TraversalMode mode,
+            std::vector<DieLocation>& entries_out, DIEType tag = DIEType::None) const;
+
+        /* Lists the subprograms at the top level of the given unit. */
+        error_t subprograms(const CompilationUnit& unit, std::vector<DieLocation>& entries_out) const;
+
+        /* Finds the compilation unit whose code contains the given address, from .debug_aranges
+           or the unit DIE's DW_AT_low_pc/DW_AT_high_pc. Returns nullptr if none is known to. */
+        const CompilationUnit* unitForAddress(std::uint64_t address) const;
+
+        /* Whether the given id is that of a DIE, indexing its unit if necessary. */
+        bool isValidId(std::uint64_t id) const;
+
+        /* Gets the compilation unit containing the DIE with the given id, which must be valid. */
+        inline const CompilationUnit& unitOf(std::uint64_t id) const {
+            return units[dieIdUnit(id)];
+        }
+
+        /* Gets the entry of the DIE with the given id, which must be valid. */
+        DieIndexEntry entry(std::uint64_t id) const;
+
+        /* Gets the id of the DIE at the given offset into .debug_info, indexing its unit if
+           necessary. Returns noDie if no DIE begins there. */
+        std::uint64_t dieAtOffset(std::uint64_t offset) const;
+
+        /* Resolves a reference attribute of a DIE in the given unit to the id of the
+           DIE it refers to (see Attribute::asReference), or returns noDie. */
+        std::uint64_t referencedDie(const CompilationUnit& unit, const Attribute& attr) const;
+
+        /* Gets the value of a string attribute of a DIE in the given unit, from whichever
+           string section its form refers to, or nullptr. */
+        const char* attributeString(const CompilationUnit& unit, const Attribute& attr) const;
+
+        /* Gets the value of an address attribute of a DIE in the given unit, whether held
+           directly (DW_FORM_addr) or by index into .debug_addr (DW_FORM_addrx*). */
+        bool attributeAddress(const CompilationUnit& unit, const Attribute& attr, std::uint64_t& address_out) const;
+
+        /* Resolve the indices of DWARF 5 forms through the given unit's contributions to the
+           offset tables, in O(1). Ranges and location lists are given as offsets into
+           .debug_rnglists and .debug_loclists respectively. The unit must be prepared, as it
+           is once any of its DIEs has been viewed (see prepareUnit). */
+        const char* indexedString(const CompilationUnit& unit, std::uint64_t index) const;
+        bool indexedAddress(const CompilationUnit& unit, std::uint64_t index, std::uint64_t& address_out) const;
+        bool rangeListOffset(const CompilationUnit& unit, std::uint64_t index, std::uint64_t& offset_out) const;
+        bool locationListOffset(const CompilationUnit& unit, std::uint64_t index, std::uint64_t& offset_out) const;
+
+        /* Tree navigation over the index. Ids must be valid; each returns noDie if there is
+           no such DIE. Subtree ends are exclusive: the ids of a DIE's descendants run from
+           id + 1 up to subtreeEnd(id). */
+        std::uint64_t firstChild(std::uint64_t id) const;
+        std::uint64_t nextSibling(std::uint64_t id) const;
+        std::uint64_t subtreeEnd(std::uint64_t id) const;
+
+        /* Iterates the children of the given DIE, in O(children). */
+        inline DieSiblingRange children(std::uint64_t id) const {
+            return DieSiblingRange{ DieSiblingIterator(this, firstChild(id)) };
+        }
+        /* Iterates the siblings following the given DIE. */
+        inline DieSiblingRange siblings(std::uint64_t id) const {
+            return DieSiblingRange{ DieSiblingIterator(this, nextSibling(id)) };
+        }
+
+        /* Gets the name of the DIE at the given position in the unit's index, or nullptr. */
+        const char* entryName(const CompilationUnit& unit, std::uint32_t index) const;
 
-        inline const auto& unitHeader() const {
-            return *header.get();
+        /* Gets the header of the first compilation unit, or nullptr if there are no units. */
+        inline const CompilationUnitHeader* unitHeader() const {
+            return units.empty() ? nullptr : units.front().header.get();
         }
     };
 
@@ -14,10 +14,9 @@ namespace dwarf
         auto size = dwarf::uleb_read(buffer, length, id_out);
 		buffer += size; length -= size;
 
-		if (id_out != 0) dwarf::uleb_read(buffer, length, type_out);
-
-        // Terminate if null entry
-        else return buffer - origBuffer;
+        // Read tag unless null entry
+		if (id_out != 0) buffer += dwarf::uleb_read(buffer, length, type_out);
+        return buffer - origBuffer;
     }
 
 
@@ -39,8 +38,8 @@ namespace dwarf
             while (true)
             {
                 std::uint32_t name, form;
-                buffer += dwarf::uleb_read(buffer, name);
-                buffer += dwarf::uleb_read(buffer, form);
+                buffer += dwarf::uleb_read(buffer, length - (buffer - origBuffer), name);
+                buffer += dwarf::uleb_read(buffer, length - (buffer - origBuffer), form);
                 if (name == 0 && form == 0) break;
             }
 
@@ -71,8 +70,8 @@ namespace dwarf
             while (true)
             {
                 std::uint32_t name, form;
-                buffer += dwarf::uleb_read(buffer, name);
-                buffer += dwarf::uleb_read(buffer, form);
+                buffer += dwarf::uleb_read(buffer, length - (buffer - origBuffer), name);
+                buffer += dwarf::uleb_read(buffer, length - (buffer - origBuffer), form);
                 if (name == 0 && form == 0) break;
             }
 
@@ -158,6 +157,11 @@ namespace dwarf
 		switch (att_out.form)
 		{
 		case AttributeForm::Address:
+		case AttributeForm::Addrx:
+		case AttributeForm::Addrx1:
+		case AttributeForm::Addrx2:
+		case AttributeForm::Addrx3:
+		case AttributeForm::Addrx4:
 			att_out.class_ = AttributeClass::Address; break;
 		case AttributeForm::Block2:
 		case AttributeForm::Block4:
@@ -170,14 +174,25 @@ namespace dwarf
 		case AttributeForm::Data1:
 		case AttributeForm::SData:
 		case AttributeForm::UData:
+		case AttributeForm::Data16:
+		case AttributeForm::ImplicitConst:
 			att_out.class_ = AttributeClass::Constant; break;
 		case AttributeForm::String:
 		case AttributeForm::Strp:
+		case AttributeForm::LineStrp:
+		case AttributeForm::StrpSup:
+		case AttributeForm::Strx:
+		case AttributeForm::Strx1:
+		case AttributeForm::Strx2:
+		case AttributeForm::Strx3:
+		case AttributeForm::Strx4:
 			att_out.class_ = AttributeClass::String; break;
 		case AttributeForm::Flag:
 		case AttributeForm::FlagPresent:
 			att_out.class_ = AttributeClass::Flag; break;
 		case AttributeForm::RefAddr:
+		case AttributeForm::RefSup4:
+		case AttributeForm::RefSup8:
 			att_out.class_ = AttributeClass::Reference; break;
 		case AttributeForm::Ref1:
 		case AttributeForm::Ref2:
@@ -189,6 +204,8 @@ namespace dwarf
 		case AttributeForm::Indirect:
 			att_out.class_ = AttributeClass::None; break;
 		case AttributeForm::SecOffset:
+		case AttributeForm::Loclistx:
+		case AttributeForm::Rnglistx:
 			att_out.class_ = AttributeClass::SectionPointer; break;
 		case AttributeForm::ExprLoc:
 			att_out.class_ = AttributeClass::ExprLoc; break;
@@ -248,13 +265,32 @@ namespace dwarf
     }
 
 
-    std::uint32_t sleb_read(const std::uint8_t data[], std::int32_t& value_out)
+    std::uint32_t sleb_read(const std::uint8_t data[], std::size_t length, std::int32_t& value_out)
     {
-		throw "NotImplemented";
+        std::int64_t value;
+        auto size = sleb_read(data, length, value);
+        value_out = static_cast<std::int32_t>(value);
+        return size;
     }
 
-    std::uint32_t sleb_read(const std::uint8_t data[], /*out*/ std::int64_t& value_out)
+    std::uint32_t sleb_read(const std::uint8_t data[], std::size_t length, /*out*/ std::int64_t& value_out)
     {
-		throw "NotImplemented";
+        std::uint64_t value = 0;
+        std::uint32_t i = 0;
+        unsigned shift = 0;
+        std::uint8_t byte = 0;
+
+        while (i < length)
+        {
+            byte = data[i++];
+            if (shift < 64) value |= static_cast<std::uint64_t>(byte & 0b01111111) << shift;
+            shift += 7;
+            if ((byte & 0b10000000) == 0) break;
+        }
+
+        // Sign-extend from the last byte read
+        if (shift < 64 && (byte & 0b01000000) != 0) value |= ~std::uint64_t(0) << shift;
+        value_out = static_cast<std::int64_t>(value);
+        return i;
     }
 }
@@ -9,6 +9,7 @@
 
 #pragma once
 #include <cstdint>
+#include <cstring>
 #include <malloc.h>
 #include <memory>
 #include <type_traits>
@@ -16,6 +17,20 @@
 
 namespace dwarf
 {
+	/* Reads an unsigned LEB value from the given buffer of the specified length.
+	   Returns the number of bytes read. */
+	std::uint32_t uleb_read(const std::uint8_t data[], std::size_t length, std::uint32_t &value_out);
+	/* Reads an unsigned LEB value from the given buffer of the specified length.
+	   Returns the number of bytes read. */
+    std::uint32_t uleb_read(const std::uint8_t data[], std::size_t length, std::uint64_t &value_out);
+
+	/* Reads a signed LEB value from the given buffer of the specified length.
+	   Returns the number of bytes read. */
+    std::uint32_t sleb_read(const std::uint8_t data[], std::size_t length, std::int32_t &value_out);
+	/* Reads a signed LEB value from the given buffer of the specified length.
+	   Returns the number of bytes read. */
+    std::uint32_t sleb_read(const std::uint8_t data[], std::size_t length, std::int64_t &value_out);
+
 
     // .debug_info section header
     struct __attribute__((packed)) CompilationUnitHeader32
@@ -27,7 +42,7 @@ namespace dwarf
     };
 
 	// .debug_info section header
-	struct CompilationUnitHeader64
+	struct __attribute__((packed)) CompilationUnitHeader64
 	{
 		std::uint32_t : 32;
 		std::uint64_t unitLength;
@@ -36,12 +51,38 @@ namespace dwarf
 		std::uint8_t  addressSize;
 	};
 
+	// .debug_info section header (DWARF 5). Skeleton and split units are followed by an
+	// 8-byte unit ID; type units by an 8-byte type signature and an offset.
+	struct __attribute__((packed)) CompilationUnitHeader32v5
+	{
+		std::uint32_t unitLength;
+		std::uint16_t version;
+		std::uint8_t  unitType;
+		std::uint8_t  addressSize;
+		std::uint32_t debugAbbrevOffset;
+	};
+
+	// .debug_info section header (DWARF 5)
+	struct __attribute__((packed)) CompilationUnitHeader64v5
+	{
+		std::uint32_t : 32;
+		std::uint64_t unitLength;
+		std::uint16_t version;
+		std::uint8_t  unitType;
+		std::uint8_t  addressSize;
+		std::uint64_t debugAbbrevOffset;
+	};
+
 	struct CompilationUnitHeader
 	{
+		virtual ~CompilationUnitHeader() = default;
+
 		virtual std::uint64_t unitLength() const = 0;
 		virtual std::uint16_t version() const = 0;
 		virtual std::uint64_t debugAbbrevOffset() const = 0;
 		virtual std::uint8_t addressSize() const = 0;
+		// Units before DWARF 5 in .debug_info are all compilation units
+		virtual UnitType unitType() const = 0;
 	};
 
 	namespace _detail
@@ -52,6 +93,14 @@ namespace dwarf
 		private:
 			HeaderType header;
 
+			template<typename T>
+			static inline auto _unitType(const T& header, int) -> decltype(header.unitType, UnitType()) {
+				return static_cast<UnitType>(header.unitType);
+			}
+			static inline UnitType _unitType(const HeaderType&, long) {
+				return UnitType::Compile;
+			}
+
 		public:
 			inline explicit CompilationUnitHeaderImpl(HeaderType header)
 				: header(header) { };
@@ -68,11 +117,18 @@ namespace dwarf
 			inline std::uint8_t addressSize() const override final {
 				return header.addressSize;
 			}
+			inline UnitType unitType() const override final {
+				return _unitType(header, 0);
+			}
 		};
 		using CompilationUnitHeader32 =
 			CompilationUnitHeaderImpl<dwarf::CompilationUnitHeader32>;
 		using CompilationUnitHeader64 =
 			CompilationUnitHeaderImpl<dwarf::CompilationUnitHeader64>;
+		using CompilationUnitHeader32v5 =
+			CompilationUnitHeaderImpl<dwarf::CompilationUnitHeader32v5>;
+		using CompilationUnitHeader64v5 =
+			CompilationUnitHeaderImpl<dwarf::CompilationUnitHeader64v5>;
 	}
 
 
@@ -212,10 +268,151 @@ namespace dwarf
 
     public:
         template<class T, class=std::enable_if_t<std::is_trivially_copyable<T>::value>>
-        inline T valueAs() {
-            T value; std::memcpy(&value, this->valueData.get(), sizeof(T));
+        inline T valueAs() const {
+            T value{}; std::memcpy(&value, this->data, sizeof(T) < size ? sizeof(T) : size);
             return value;
         }
+
+        /* Typed accessors. Each decodes the value in place from 'data' according to the
+           attribute's form, returning false if the form does not hold that kind of value. */
+
+        /* Gets a constant (DW_FORM_data*, udata, implicit_const) as an unsigned value. */
+        inline bool asUnsigned(std::uint64_t& value_out) const noexcept
+        {
+            switch (form)
+            {
+                case AttributeForm::Data1: case AttributeForm::Data2:
+                case AttributeForm::Data4: case AttributeForm::Data8:
+                case AttributeForm::ImplicitConst:
+                    return readFixed(value_out);
+                case AttributeForm::UData:
+                    uleb_read(data, size, value_out); return true;
+                default: return false;
+            }
+        }
+
+        /* Gets a constant (DW_FORM_data*, sdata, implicit_const) as a signed value.
+           Fixed-size constants are sign-extended. */
+        inline bool asSigned(std::int64_t& value_out) const noexcept
+        {
+            switch (form)
+            {
+                case AttributeForm::Data1: case AttributeForm::Data2:
+                case AttributeForm::Data4: case AttributeForm::Data8:
+                case AttributeForm::ImplicitConst:
+                {
+                    std::uint64_t value;
+                    if (!readFixed(value)) return false;
+
+                    unsigned shift = 64 - 8 * static_cast<unsigned>(size);
+                    value_out = static_cast<std::int64_t>(value << shift) >> shift;
+                    return true;
+                }
+                case AttributeForm::SData:
+                    sleb_read(data, size, value_out); return true;
+                default: return false;
+            }
+        }
+
+        /* Gets a target address (DW_FORM_addr). */
+        inline bool asAddress(std::uint64_t& address_out) const noexcept {
+            return form == AttributeForm::Address && readFixed(address_out);
+        }
+
+        /* Gets a flag (DW_FORM_flag, flag_present). */
+        inline bool asFlag(bool& flag_out) const noexcept
+        {
+            if (form == AttributeForm::FlagPresent) flag_out = true;
+            else if (form == AttributeForm::Flag && size == 1) flag_out = data[0] != 0;
+            else return false;
+            return true;
+        }
+
+        /* Gets a string, either inline (DW_FORM_string) or resolved from the given
+           .debug_str contents (DW_FORM_strp). */
+        inline bool asString(const std::uint8_t* debugStr, std::uint64_t debugStrSize,
+            const char*& string_out) const noexcept
+        {
+            if (form == AttributeForm::String) {
+                string_out = reinterpret_cast<const char*>(data);
+                return true;
+            }
+            std::uint64_t offset;
+            if (form != AttributeForm::Strp || debugStr == nullptr || !readFixed(offset) ||
+                offset >= debugStrSize) return false;
+
+            string_out = reinterpret_cast<const char*>(debugStr + offset);
+            return true;
+        }
+
+        /* Gets a reference to another DIE as an offset into .debug_info. References
+           other than DW_FORM_ref_addr are relative to the start of the unit at the
+           given offset. Type signatures (DW_FORM_ref_sig8) are not offsets. */
+        inline bool asReference(std::uint64_t unitOffset, std::uint64_t& offset_out) const noexcept
+        {
+            switch (form)
+            {
+                case AttributeForm::Ref1: case AttributeForm::Ref2:
+                case AttributeForm::Ref4: case AttributeForm::Ref8:
+                    if (!readFixed(offset_out)) return false;
+                    offset_out += unitOffset; return true;
+                case AttributeForm::RefUData:
+                    uleb_read(data, size, offset_out);
+                    offset_out += unitOffset; return true;
+                case AttributeForm::RefAddr:
+                    return readFixed(offset_out);
+                default: return false;
+            }
+        }
+
+        /* Gets an offset into another section (DW_FORM_sec_offset, strp, line_strp,
+           strp_sup), e.g. of a line table or of a string. */
+        inline bool asSectionOffset(std::uint64_t& offset_out) const noexcept
+        {
+            switch (form)
+            {
+                case AttributeForm::SecOffset: case AttributeForm::Strp:
+                case AttributeForm::LineStrp: case AttributeForm::StrpSup:
+                    return readFixed(offset_out);
+                default: return false;
+            }
+        }
+
+        /* Gets the index held by a DWARF 5 indexed form (DW_FORM_strx*, addrx*,
+           rnglistx, loclistx). See DwarfContext for resolving indices. */
+        inline bool asIndex(std::uint64_t& index_out) const noexcept
+        {
+            switch (form)
+            {
+                case AttributeForm::Strx1: case AttributeForm::Strx2:
+                case AttributeForm::Strx3: case AttributeForm::Strx4:
+                case AttributeForm::Addrx1: case AttributeForm::Addrx2:
+                case AttributeForm::Addrx3: case AttributeForm::Addrx4:
+                    return readFixed(index_out);
+                case AttributeForm::Strx: case AttributeForm::Addrx:
+                case AttributeForm::Rnglistx: case AttributeForm::Loclistx:
+                    uleb_read(data, size, index_out); return true;
+                default: return false;
+            }
+        }
+
+        /* Gets the contents of a block or expression (DW_FORM_block*, exprloc),
+           without its length prefix. */
+        inline bool asBlock(const std::uint8_t*& data_out, std::size_t& size_out) const noexcept
+        {
+            if (class_ != AttributeClass::Block && class_ != AttributeClass::ExprLoc) return false;
+            data_out = data; size_out = size;
+            return true;
+        }
+
+    private:
+        // Reads a little-endian fixed-size value of up to 8 bytes
+        inline bool readFixed(std::uint64_t& value_out) const noexcept
+        {
+            if (size == 0 || size > sizeof(value_out)) return false;
+            value_out = 0; std::memcpy(&value_out, data, size);
+            return true;
+        }
     };
 
 
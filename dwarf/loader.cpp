@@ -0,0 +1,250 @@
+/* loader.cpp - (c) James S Renwick 2020 */
+#include <cstring>
+#include <unordered_map>
+#include "loader.hpp"
+#include "../elf/debuglink.hpp"
+#include "../elf/notes.hpp"
+
+namespace dwarf
+{
+    static bool _loadSection(const elf::ElfFile& file, std::size_t index, SectionType type,
+                             DwarfSection& section_out)
+    {
+        elf::SectionHeader header;
+        elf::SectionView contents = file.sectionData(index);
+        if (!contents || !file.sectionHeader(index, header)) return false;
+
+        section_out = DwarfSection(type, contents.data, contents.size);
+        section_out.fileOffset = header.sh_offset;
+        return true;
+    }
+
+
+    bool loadSection(const elf::ElfFile& file, SectionType type, DwarfSection& section_out)
+    {
+        const char* name = SectionTypeToString(type);
+        if (name == nullptr) return false;
+
+        std::size_t index;
+        if (file.sectionIndex(name, index)) {
+            return _loadSection(file, index, type, section_out);
+        }
+
+        // Try the legacy compressed name, ".zdebug_*"
+        char zname[32] = ".z";
+        std::strncat(zname, name + 1, sizeof(zname) - 3);
+        if (file.sectionIndex(zname, index)) {
+            return _loadSection(file, index, type, section_out);
+        }
+        return false;
+    }
+
+
+    std::size_t loadSections(const elf::ElfFile& file, std::vector<DwarfSection>& sections_out)
+    {
+        std::size_t count = 0;
+        std::size_t index = 0;
+
+        for (const elf::SectionHeader& header : file.sectionHeaders())
+        {
+            const char* name = file.sectionName(header);
+            auto type = name != nullptr ? SectionTypeFromString(name) : SectionType::invalid;
+
+            DwarfSection section;
+            if (type != SectionType::invalid && _loadSection(file, index, type, section))
+            {
+                sections_out.push_back(std::move(section));
+                count++;
+            }
+            index++;
+        }
+        return count;
+    }
+
+
+    DebugFileLocator::DebugFileLocator(std::string root) : root(std::move(root)) { }
+
+
+    DebugFileLocator& DebugFileLocator::shared()
+    {
+        static DebugFileLocator locator;
+        return locator;
+    }
+
+
+    void DebugFileLocator::setRoot(std::string root)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->root = std::move(root);
+        misses.clear();
+    }
+
+
+    std::string DebugFileLocator::getRoot() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return root;
+    }
+
+
+    void DebugFileLocator::clearMisses()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        misses.clear();
+    }
+
+
+    bool DebugFileLocator::tryBuildId(std::string_view buildId, const char* path,
+                                      elf::ElfFile& debugFile_out) const
+    {
+        elf::ElfFile file;
+        if (!file.open(path)) return false;
+
+        elf::SectionView fileBuildId;
+        if (!elf::readBuildId(file, fileBuildId) ||
+            elf::formatBuildId(fileBuildId) != buildId) return false;
+
+        debugFile_out = std::move(file);
+        return true;
+    }
+
+
+    bool DebugFileLocator::tryDebugLink(std::uint32_t crc, const std::string& path,
+                                        elf::ElfFile& debugFile_out) const
+    {
+        elf::ElfFile file;
+        if (!file.open(path.c_str())) return false;
+        if (elf::debugLinkCrc(file.data(), file.size()) != crc) return false;
+
+        debugFile_out = std::move(file);
+        return true;
+    }
+
+
+    bool DebugFileLocator::locate(const elf::ElfFile& binary, const char* binaryPath,
+                                  elf::ElfFile& debugFile_out) const
+    {
+        std::string buildId;
+        elf::SectionView buildIdNote;
+        if (elf::readBuildId(binary, buildIdNote)) buildId = elf::formatBuildId(buildIdNote);
+
+        std::string key = !buildId.empty() ? buildId : std::string("path:") + binaryPath;
+        std::string root;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (misses.count(key) != 0) return false;
+            root = this->root;
+        }
+
+        // Try <root>/.build-id/xx/yyyy.debug
+        if (buildId.size() > 2)
+        {
+            auto path = root + "/.build-id/" + buildId.substr(0, 2) + "/" + buildId.substr(2) + ".debug";
+            if (tryBuildId(buildId, path.c_str(), debugFile_out)) return true;
+        }
+
+        // Try .gnu_debuglink in <dir>, <dir>/.debug and <root>/<dir>
+        std::string_view linkName; std::uint32_t crc;
+        if (elf::readDebugLink(binary, linkName, crc))
+        {
+            std::string dir = binaryPath;
+            auto slash = dir.rfind('/');
+            dir = slash == std::string::npos ? std::string(".") : dir.substr(0, slash);
+
+            std::string name(linkName);
+            if (tryDebugLink(crc, dir + "/" + name, debugFile_out) ||
+                tryDebugLink(crc, dir + "/.debug/" + name, debugFile_out) ||
+                (dir[0] == '/' && tryDebugLink(crc, root + dir + "/" + name, debugFile_out))) {
+                return true;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        misses.insert(std::move(key));
+        return false;
+    }
+
+
+    static std::mutex _imagesMutex{};
+    static std::unordered_map<std::string, std::weak_ptr<DebugImage>> _images{};
+
+
+    static DwarfWidth _detectWidth(const DwarfSection& info)
+    {
+        // 64-bit DWARF units begin with the escape 0xffffffff
+        std::uint32_t length = 0;
+        if (info.size >= sizeof(length)) std::memcpy(&length, info.data.get(), sizeof(length));
+        return length == 0xffffffff ? DwarfWidth::Bits64 : DwarfWidth::Bits32;
+    }
+
+
+    static std::shared_ptr<DebugImage> _buildImage(elf::ElfFile&& binary, const char* filepath,
+                                                   const DebugFileLocator& locator)
+    {
+        auto image = std::make_shared<DebugImage>();
+        image->binary = std::move(binary);
+
+        // Use the separate debug file if the binary is stripped
+        DwarfSection info;
+        if (!loadSection(image->binary, SectionType::debug_info, info))
+        {
+            if (!locator.locate(image->binary, filepath, image->debugFile)) return nullptr;
+            if (!loadSection(image->debugFile, SectionType::debug_info, info)) return nullptr;
+        }
+
+        std::vector<DwarfSection> sections;
+        loadSections(image->dwarfFile(), sections);
+
+        image->context = std::make_unique<DwarfContext>(std::move(sections), _detectWidth(info));
+        if (image->context->buildIndexes() != 0) return nullptr;
+        return image;
+    }
+
+
+    std::shared_ptr<DebugImage> openImage(const char* filepath, const DebugFileLocator& locator)
+    {
+        elf::ElfFile binary;
+        if (!binary.open(filepath)) return nullptr;
+
+        elf::SectionView buildId;
+        if (!elf::readBuildId(binary, buildId)) return _buildImage(std::move(binary), filepath, locator);
+
+        auto key = elf::formatBuildId(buildId);
+        {
+            std::lock_guard<std::mutex> lock(_imagesMutex);
+            auto it = _images.find(key);
+            if (it != _images.end())
+            {
+                if (auto image = it->second.lock()) return image;
+            }
+        }
+
+        // Index outside the lock; if another thread won the race, use its image
+        auto image = _buildImage(std::move(binary), filepath, locator);
+        if (image == nullptr) return nullptr;
+
+        std::lock_guard<std::mutex> lock(_imagesMutex);
+        auto& entry = _images[key];
+        if (auto existing = entry.lock()) return existing;
+        entry = image;
+
+        // Drop the entries of images since released. Building an image costs far more
+        // than the sweep, so the map stays bounded by the images in use.
+        for (auto it = _images.begin(); it != _images.end(); )
+        {
+            if (it->second.expired()) it = _images.erase(it);
+            else ++it;
+        }
+        return image;
+    }
+
+
+    std::shared_ptr<DwarfContext> openContext(const char* filepath)
+    {
+        auto image = openImage(filepath);
+        if (image == nullptr) return nullptr;
+
+        // Share ownership of the image, exposing only the context
+        return std::shared_ptr<DwarfContext>(image, image->context.get());
+    }
+}
@@ -0,0 +1,99 @@
+/* loader.hpp - (c) James S Renwick 2020 */
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include "../elf/file.hpp"
+#include "dwarf.hpp"
+
+namespace dwarf
+{
+    /* Loads the DWARF section of the given type from an ELF file.
+
+       Uncompressed sections borrow the file's mapping. Compressed sections (SHF_COMPRESSED
+       or .zdebug_*) are inflated by the file on first access and borrowed from its cache,
+       so each is decompressed at most once however many times it is loaded. The file must
+       outlive the section.
+
+       Returns false if the file has no such section or it cannot be decompressed. */
+    bool loadSection(const elf::ElfFile& file, SectionType type, DwarfSection& section_out);
+
+    /* Loads every recognised DWARF section of the given ELF file.
+       Returns the number of sections loaded. */
+    std::size_t loadSections(const elf::ElfFile& file, std::vector<DwarfSection>& sections_out);
+
+
+    /* Locates the separate debug file of a stripped binary, as installed by -dbg packages.
+
+       The debug file is looked for by build-ID, as <root>/.build-id/xx/yyyy.debug, then by
+       the .gnu_debuglink name in the binary's directory, its .debug subdirectory and under
+       <root> followed by the binary's directory. Debug-link candidates must match the recorded
+       CRC-32; build-ID candidates must carry the same build-ID.
+
+       Failed lookups are remembered (by build-ID, or by path for binaries without one) so
+       the filesystem is not searched again for the same binary. Safe to use concurrently. */
+    class DebugFileLocator
+    {
+    private:
+        std::string root{};
+
+        mutable std::mutex mutex{};
+        mutable std::unordered_set<std::string> misses{};
+
+    public:
+        explicit DebugFileLocator(std::string root = "/usr/lib/debug");
+
+        /* Gets the locator used by openContext. */
+        static DebugFileLocator& shared();
+
+        /* Sets the debug root, forgetting any failed lookups. */
+        void setRoot(std::string root);
+        std::string getRoot() const;
+
+        /* Forgets all failed lookups, e.g. after installing debug packages. */
+        void clearMisses();
+
+        /* Finds and opens the separate debug file for the given binary, which was opened
+           from the given path. Returns false if none is found. */
+        bool locate(const elf::ElfFile& binary, const char* binaryPath, elf::ElfFile& debugFile_out) const;
+
+    private:
+        bool tryBuildId(std::string_view buildId, const char* path, elf::ElfFile& debugFile_out) const;
+        bool tryDebugLink(std::uint32_t crc, const std::string& path, elf::ElfFile& debugFile_out) const;
+    };
+
+
+    /* A binary together with its indexed DWARF context. Where the binary is stripped and
+       its debug information is in a separate file, the DWARF sections are loaded from that
+       file while program headers and symbols remain those of the binary. */
+    struct DebugImage
+    {
+        elf::ElfFile binary{};
+        elf::ElfFile debugFile{}; // Not open if the binary carries its own DWARF
+        std::unique_ptr<DwarfContext> context{};
+
+    public:
+        /* Gets the file the DWARF sections were loaded from. */
+        inline const elf::ElfFile& dwarfFile() const noexcept {
+            return debugFile.isOpen() ? debugFile : binary;
+        }
+    };
+
+
+    /* Opens the ELF file at the given path along with its DWARF context, with indexes built.
+       If the file has no .debug_info, its separate debug file is located with the given locator.
+
+       Images are shared by build-ID (NT_GNU_BUILD_ID): if an image for a file with the same
+       build-ID is still alive, it is returned as-is and the file is neither loaded nor indexed
+       again. Files without a build-ID are never shared. Safe to call concurrently.
+
+       Returns nullptr if the file cannot be opened, has no DWARF or fails to index. */
+    std::shared_ptr<DebugImage> openImage(const char* filepath,
+        const DebugFileLocator& locator = DebugFileLocator::shared());
+
+    /* As openImage, returning only the context. The context keeps its image alive. */
+    std::shared_ptr<DwarfContext> openContext(const char* filepath);
+}
@@ -0,0 +1,86 @@
+/* names.cpp - (c) James S Renwick 2020 */
+#include <cstring>
+#include "names.hpp"
+
+namespace dwarf
+{
+    void NameIndex::build(const std::vector<std::vector<NamedEntry>>& entries)
+    {
+        clear();
+
+        std::size_t total = 0;
+        for (auto& unitEntries : entries) total += unitEntries.size();
+
+        // Size the table for a load factor of at most 1/2, assuming distinct names
+        std::size_t capacity = 16;
+        while (capacity < total * 2) capacity *= 2;
+        std::vector<std::uint32_t> slots(capacity, emptySlot);
+        mask = capacity - 1;
+
+        // Intern each name, counting its DIEs
+        std::vector<Name> names;
+        std::vector<const char*> strings;
+        std::vector<std::uint32_t> nameOf;
+        nameOf.reserve(total);
+
+        for (auto& unitEntries : entries)
+        {
+            for (auto& entry : unitEntries)
+            {
+                std::string_view name(entry.name, entry.length);
+                std::size_t slot = entry.hash & mask;
+
+                while (true)
+                {
+                    auto position = slots[slot];
+                    if (position == emptySlot)
+                    {
+                        position = slots[slot] = static_cast<std::uint32_t>(names.size());
+                        names.push_back(Name{ entry.hash, entry.length, 0, 0, 0 });
+                        strings.push_back(entry.name);
+                    }
+                    auto& existing = names[position];
+                    if (existing.hash == entry.hash && std::string_view(strings[position], existing.length) == name)
+                    {
+                        existing.count++;
+                        nameOf.push_back(position);
+                        break;
+                    }
+                    slot = (slot + 1) & mask;
+                }
+            }
+        }
+
+        // Lay out each name's DIEs contiguously, preserving order
+        std::uint32_t first = 0;
+        for (auto& name : names) {
+            name.first = first; first += name.count; name.count = 0;
+        }
+        std::vector<std::uint64_t> ids(total);
+        std::vector<DIEType> tags(total);
+
+        std::size_t i = 0;
+        for (auto& unitEntries : entries)
+        {
+            for (auto& entry : unitEntries)
+            {
+                auto& name = names[nameOf[i++]];
+                auto position = name.first + name.count++;
+                ids[position] = entry.id;
+                tags[position] = entry.tag;
+            }
+        }
+
+        this->names = std::move(names);
+        this->slots = std::move(slots);
+        this->ids = std::move(ids);
+        this->tags = std::move(tags);
+    }
+
+
+    void NameIndex::clear() noexcept
+    {
+        names.clear(); slots.clear(); mask = 0;
+        ids.clear(); tags.clear();
+    }
+}
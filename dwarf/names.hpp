@@ -0,0 +1,109 @@
+/* names.hpp - (c) James S Renwick 2020 */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "column.hpp"
+#include "const.hpp"
+
+namespace dwarf
+{
+    /* A named DIE, as collected while indexing a unit. */
+    struct NamedEntry
+    {
+        std::uint64_t hash;
+        const char* name;
+        std::uint32_t length;
+        DIEType tag;
+        std::uint64_t id;
+    };
+
+
+    /* Hash index from DIE names to the ids of the DIEs bearing them. Each distinct name is
+       interned once with its precomputed hash; its DIEs are held contiguously, in .debug_info
+       order, along with their tags for filtering. The index holds no pointers: a name's
+       string is that of its first DIE, resolved by the caller when hashes match. */
+    class NameIndex
+    {
+        friend class IndexCache;
+
+    private:
+        struct Name
+        {
+            std::uint64_t hash;
+            std::uint32_t length;
+            std::uint32_t first; // Position of the name's first DIE in 'ids'
+            std::uint32_t count;
+            std::uint32_t reserved;
+        };
+        static constexpr std::uint32_t emptySlot = static_cast<std::uint32_t>(-1);
+
+        Column<Name> names{};
+        Column<std::uint32_t> slots{}; // Open-addressed positions in 'names'
+        std::size_t mask{};
+
+        Column<std::uint64_t> ids{};
+        Column<DIEType> tags{};
+
+    public:
+        /* FNV-1a hash of the given name. */
+        static inline std::uint64_t hash(std::string_view name) noexcept
+        {
+            std::uint64_t value = 0xcbf29ce484222325ull;
+            for (unsigned char c : name) {
+                value = (value ^ c) * 0x100000001b3ull;
+            }
+            return value;
+        }
+
+        /* Builds the index from the named DIEs of each unit, given in unit order. */
+        void build(const std::vector<std::vector<NamedEntry>>& entries);
+
+        void clear() noexcept;
+
+        /* Appends the ids of the DIEs with the given name (and tag, unless DIEType::None)
+           to 'ids_out'. Names are compared with nameOf(id), which gets the name of the DIE
+           with the given id, or nullptr if there is none. Returns the number of ids appended.
+           Positions are checked as they are read, so an index borrowed from a corrupt file
+           finds nothing rather than reading out of bounds. */
+        template<typename NameOf>
+        std::size_t lookup(std::string_view name, DIEType tag, NameOf&& nameOf,
+            std::vector<std::uint64_t>& ids_out) const
+        {
+            if (slots.empty()) return 0;
+
+            auto hash = NameIndex::hash(name);
+            std::size_t slot = hash & mask;
+            for (std::size_t probes = 0; probes < slots.size() && slots[slot] != emptySlot; probes++, slot = (slot + 1) & mask)
+            {
+                if (slots[slot] >= names.size()) return 0;
+
+                auto& entry = names[slots[slot]];
+                if (entry.hash != hash || entry.length != name.size()) continue;
+                if (entry.count == 0 || entry.first >= ids.size() || entry.count > ids.size() - entry.first) return 0;
+
+                const char* existing = nameOf(ids[entry.first]);
+                if (existing == nullptr || std::string_view(existing, entry.length) != name) continue;
+
+                std::size_t count = 0;
+                for (std::uint32_t i = entry.first; i < entry.first + entry.count; i++)
+                {
+                    if (tag == DIEType::None || tags[i] == tag) {
+                        ids_out.push_back(ids[i]); count++;
+                    }
+                }
+                return count;
+            }
+            return 0;
+        }
+
+        inline bool empty() const noexcept {
+            return names.empty();
+        }
+        /* Gets the number of distinct names indexed. */
+        inline std::size_t nameCount() const noexcept {
+            return names.size();
+        }
+    };
+}
@@ -0,0 +1,80 @@
+/* workers.cpp - (c) James S Renwick 2020 */
+#include <algorithm>
+#include <atomic>
+#include "workers.hpp"
+
+namespace dwarf
+{
+    WorkerPool::~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& thread : threads) thread.join();
+    }
+
+
+    void WorkerPool::workerMain()
+    {
+        std::uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
+        {
+            // Join each new loop while it still wants threads
+            wake.wait(lock, [&]() { return stopping || (generation != seen && claimed < wanted); });
+            if (stopping) return;
+
+            seen = generation;
+            claimed++;
+            auto* work = job;
+
+            lock.unlock();
+            (*work)();
+            lock.lock();
+
+            if (--active == 0) done.notify_all();
+        }
+    }
+
+
+    void WorkerPool::run(std::size_t count, unsigned threadCount, const std::function<void(std::size_t)>& func)
+    {
+        if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+        if (threadCount > count) threadCount = static_cast<unsigned>(count);
+
+        // Each thread takes the next unclaimed item until all are done
+        std::atomic<std::size_t> next{0};
+        const std::function<void()> work = [&]() {
+            for (std::size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count; ) func(i);
+        };
+        if (threadCount <= 1) { work(); return; }
+
+        std::lock_guard<std::mutex> serialise(runMutex);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            while (threads.size() < threadCount - 1) threads.emplace_back(&WorkerPool::workerMain, this);
+
+            job = &work;
+            generation++;
+            wanted = active = threadCount - 1;
+            claimed = 0;
+        }
+        wake.notify_all();
+        work();
+
+        // 'work' refers to this frame, so wait for every pool thread to finish with it
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&]() { return active == 0; });
+        job = nullptr;
+        wanted = 0;
+    }
+
+
+    std::size_t WorkerPool::size()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return threads.size();
+    }
+}
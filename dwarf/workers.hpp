@@ -0,0 +1,49 @@
+/* workers.hpp - (c) James S Renwick 2020 */
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dwarf
+{
+    /* Threads kept to run parallel loops, so that repeated loops do not each pay the cost of
+       starting threads. Threads are started as first needed and stopped on destruction.
+       Loops run one at a time; a loop must not start another on the same pool. */
+    class WorkerPool
+    {
+    private:
+        std::mutex runMutex{}; // Held for the whole of each loop
+
+        std::mutex mutex{};
+        std::condition_variable wake{};
+        std::condition_variable done{};
+        std::vector<std::thread> threads{};
+
+        // The current loop's work, run by 'wanted' pool threads
+        const std::function<void()>* job{};
+        std::uint64_t generation{};
+        unsigned wanted{};
+        unsigned claimed{};
+        unsigned active{};
+        bool stopping{};
+
+        void workerMain();
+
+    public:
+        WorkerPool() = default;
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+        ~WorkerPool();
+
+        /* Runs func(i) for i in [0, count) on up to 'threadCount' threads (by default, one
+           per core), including the calling thread. Returns once every call has returned. */
+        void run(std::size_t count, unsigned threadCount, const std::function<void(std::size_t)>& func);
+
+        /* Gets the number of threads started so far, not counting callers of run(). */
+        std::size_t size();
+    };
+}
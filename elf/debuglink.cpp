@@ -0,0 +1,40 @@
+/* debuglink.cpp - (c) James S Renwick 2020 */
+#include <cstring>
+#include <zlib.h>
+#include "debuglink.hpp"
+
+
+namespace elf
+{
+    bool readDebugLink(const ElfFile& file, std::string_view& name_out, std::uint32_t& crc_out)
+    {
+        SectionView link = file.section(".gnu_debuglink");
+        if (!link) return false;
+
+        // Name is null-terminated and padded to 4 bytes, followed by the CRC
+        auto* end = static_cast<const std::uint8_t*>(std::memchr(link.data, '\0', link.size));
+        if (end == nullptr || end == link.data) return false;
+
+        std::size_t crcOffset = ((end - link.data) + 4) & ~std::size_t(3);
+        if (crcOffset + sizeof(crc_out) > link.size) return false;
+
+        name_out = std::string_view(reinterpret_cast<const char*>(link.data), end - link.data);
+        std::memcpy(&crc_out, link.data + crcOffset, sizeof(crc_out));
+        return true;
+    }
+
+
+    std::uint32_t debugLinkCrc(const std::uint8_t* data, std::size_t size)
+    {
+        uLong crc = crc32(0L, Z_NULL, 0);
+
+        // Feed in chunks as zlib takes a uInt length
+        while (size != 0)
+        {
+            uInt chunk = size > 0x40000000 ? 0x40000000 : static_cast<uInt>(size);
+            crc = crc32(crc, data, chunk);
+            data += chunk; size -= chunk;
+        }
+        return static_cast<std::uint32_t>(crc);
+    }
+}
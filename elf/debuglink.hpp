@@ -0,0 +1,18 @@
+/* debuglink.hpp - (c) James S Renwick 2020 */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include "file.hpp"
+
+
+namespace elf
+{
+    /* Reads the .gnu_debuglink section of the given file: the file name of the separate
+       debug file and the CRC-32 of its contents. */
+    bool readDebugLink(const ElfFile& file, std::string_view& name_out, std::uint32_t& crc_out);
+
+    /* Computes the CRC-32 used by .gnu_debuglink (as zlib's crc32) over the given bytes. */
+    std::uint32_t debugLinkCrc(const std::uint8_t* data, std::size_t size);
+}
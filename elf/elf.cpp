@@ -19,7 +19,8 @@ namespace elf
     bool decodeElfHeader(const std::uint8_t* data, std::size_t dataSize, Header& header_out)
     {
         // Check magic
-        if (data[0] != '\x7f' && data[1] != 'E' && data[2] != 'L' && data[3] != 'F') return false;
+        if (dataSize < EI_NIDENT) return false;
+        if (data[0] != '\x7f' || data[1] != 'E' || data[2] != 'L' || data[3] != 'F') return false;
 
         // If 64-bit
         if (static_cast<ElfClass>(data[4]) == ElfClass::class64) {
@@ -93,6 +94,54 @@ namespace elf
             entry_out.st_shndx = e32.st_shndx;
             entry_out.st_value = e32.st_value;
             entry_out.st_size = e32.st_size;
+            return true;
+        }
+        return false;
+    }
+
+    bool decodeProgramHeader(const std::uint8_t* data, std::size_t dataSize, ElfClass el_class,
+                             ProgramHeaderEntry& header_out)
+    {
+        // If 64-bit
+        if (el_class == ElfClass::class64) {
+            return _decode_common(data, dataSize, header_out);
+        }
+        else if (el_class == ElfClass::class32)
+        {
+            ProgramHeaderEntry32 h32;
+            if (!_decode_common(data, dataSize, h32)) return false;
+            header_out.p_type = h32.p_type;
+            header_out.p_flags = h32.p_flags;
+            header_out.p_offset = h32.p_offset;
+            header_out.p_vaddr = h32.p_vaddr;
+            header_out.p_paddr = h32.p_paddr;
+            header_out.p_filesz = h32.p_filesz;
+            header_out.p_memsz = h32.p_memsz;
+            header_out.p_align = h32.p_align;
+            return true;
+        }
+        return false;
+    }
+
+    bool decodeCompressionHeader(const std::uint8_t* data, std::size_t dataSize, ElfClass el_class,
+                                 CompressionHeader& header_out, std::size_t& headerSize_out)
+    {
+        // If 64-bit
+        if (el_class == ElfClass::class64)
+        {
+            headerSize_out = sizeof(CompressionHeader64);
+            return _decode_common(data, dataSize, header_out);
+        }
+        else if (el_class == ElfClass::class32)
+        {
+            CompressionHeader32 h32;
+            if (!_decode_common(data, dataSize, h32)) return false;
+            header_out.ch_type = h32.ch_type;
+            header_out.ch_reserved = 0;
+            header_out.ch_size = h32.ch_size;
+            header_out.ch_addralign = h32.ch_addralign;
+            headerSize_out = sizeof(CompressionHeader32);
+            return true;
         }
         return false;
     }
@@ -5,14 +5,18 @@
 #include <cstddef>
 #include <memory>
 #include <cstring>
+#include <type_traits>
 
 #define EI_NIDENT 16
 
+#define SHF_COMPRESSED 0x800 // Section data is compressed (see CompressionHeader)
+
 
 namespace elf
 {
     enum class ElfClass : std::uint8_t
     {
+        none    = 0, // Invalid class, or (as a template argument) selected at runtime
         class32 = 1,
         class64 = 2
     };
@@ -74,7 +78,8 @@ namespace elf
         NoBits   = 0x8, // Program-specific, occupies no space
         Rel      = 0x9, // Relocation entries w/o explicit addends
         ShLib    = 0xA, // Reserved. ABI-rejected.
-        DynSym   = 0xB  // Dynamic linking symbol table
+        DynSym   = 0xB, // Dynamic linking symbol table
+        GnuHash  = 0x6FFFFFF6 // GNU-style symbol hash table
     };
 
 
@@ -110,6 +115,34 @@ namespace elf
     using SectionHeader = SectionHeader64;
 
 
+    enum class CompressionType : std::uint32_t
+    {
+        Zlib = 1, // ZLIB/DEFLATE
+        Zstd = 2  // Zstandard
+    };
+
+
+    /* Header preceding the data of SHF_COMPRESSED sections. */
+    struct __attribute__((packed)) CompressionHeader32
+    {
+        CompressionType ch_type;      // Compression algorithm
+        std::uint32_t   ch_size;      // Uncompressed data size
+        std::uint32_t   ch_addralign; // Uncompressed data alignment
+    };
+    static_assert(sizeof(CompressionHeader32) == 12, "");
+
+
+    struct __attribute__((packed)) CompressionHeader64
+    {
+        CompressionType ch_type;      // Compression algorithm
+        std::uint32_t   ch_reserved;
+        std::uint64_t   ch_size;      // Uncompressed data size
+        std::uint64_t   ch_addralign; // Uncompressed data alignment
+    };
+    static_assert(sizeof(CompressionHeader64) == 24, "");
+    using CompressionHeader = CompressionHeader64;
+
+
     enum class SegmentType : std::uint32_t
     {
         Null          = 0x0, // Unused - ignore entry
@@ -118,7 +151,8 @@ namespace elf
         Interpreted   = 0x3, // Interpreter location for interpreted executables
         Note          = 0x4, // Location and size of auxiliary information
         SHLib         = 0x5, // Reserved
-        ProgramHeader = 0x6  // Location and size of Program Header for loading
+        ProgramHeader = 0x6, // Location and size of Program Header for loading
+        TLS           = 0x7  // Thread-local storage template
     };
 
 
@@ -142,6 +176,23 @@ namespace elf
         SegmentFlags p_flags;  // Segment flags
         std::uint32_t     p_align;  // Segment load alignment
     };
+    static_assert(sizeof(ProgramHeaderEntry32) == 32, "");
+
+
+    /* Entry describing a loaded program segment. */
+    struct __attribute__((packed)) ProgramHeaderEntry64
+    {
+        SegmentType  p_type;   // Segment type
+        SegmentFlags p_flags;  // Segment flags
+        std::uint64_t     p_offset; // Segment offset in source file
+        std::uint64_t     p_vaddr;  // Segment virtual address load location
+        std::uint64_t     p_paddr;  // Segment physical address load location
+        std::uint64_t     p_filesz; // Segment source size in bytes
+        std::uint64_t     p_memsz;  // Segment load size in bytes
+        std::uint64_t     p_align;  // Segment load alignment
+    };
+    static_assert(sizeof(ProgramHeaderEntry64) == 56, "");
+    using ProgramHeaderEntry = ProgramHeaderEntry64;
 
 
     enum class SymbolBinding : std::uint8_t
@@ -190,11 +241,51 @@ namespace elf
     using SymbolTableEntry = SymbolTableEntry64;
 
 
+    /* Native record layouts for each ELF class. */
+    template<ElfClass Class>
+    struct class_layout;
+
+    template<>
+    struct class_layout<ElfClass::class32>
+    {
+        using SectionHeader = SectionHeader32;
+        using SymbolTableEntry = SymbolTableEntry32;
+        using ProgramHeaderEntry = ProgramHeaderEntry32;
+    };
+
+    template<>
+    struct class_layout<ElfClass::class64>
+    {
+        using SectionHeader = SectionHeader64;
+        using SymbolTableEntry = SymbolTableEntry64;
+        using ProgramHeaderEntry = ProgramHeaderEntry64;
+    };
+
+    template<ElfClass Class>
+    using elf_class_t = std::integral_constant<ElfClass, Class>;
+
+    /* Calls 'func' with elf_class_t<el_class>, so that code templated on the ELF class
+       is selected once (e.g. per file) rather than branching on the class per record.
+       Invalid classes dispatch as 32-bit. */
+    template<typename Func>
+    inline decltype(auto) dispatch_class(ElfClass el_class, Func&& func)
+    {
+        if (el_class == ElfClass::class64) {
+            return func(elf_class_t<ElfClass::class64>());
+        }
+        return func(elf_class_t<ElfClass::class32>());
+    }
+
+
     bool decodeElfHeader(const std::uint8_t* data, std::size_t dataSize, Header& header_out);
     bool decodeSectionHeader(const std::uint8_t* data, std::size_t dataSize, ElfClass el_class,
                              SectionHeader& header_out);
     bool decodeSymbolTableEntry(const std::uint8_t* data, std::size_t dataSize, ElfClass el_class,
                                 SymbolTableEntry& entry_out);
+    bool decodeProgramHeader(const std::uint8_t* data, std::size_t dataSize, ElfClass el_class,
+                             ProgramHeaderEntry& header_out);
+    bool decodeCompressionHeader(const std::uint8_t* data, std::size_t dataSize, ElfClass el_class,
+                                 CompressionHeader& header_out, std::size_t& headerSize_out);
 
 
     template<typename T>
@@ -249,6 +340,26 @@ namespace elf
     };
 
 
+    struct program_header_decoder
+    {
+        ElfClass el_class;
+        std::size_t elementSize;
+
+        inline program_header_decoder(ElfClass el_class) : el_class(el_class)
+        {
+            elementSize = el_class == ElfClass::class64 ?
+                        sizeof(ProgramHeaderEntry64) : sizeof(ProgramHeaderEntry32);
+        }
+        program_header_decoder(const program_header_decoder&) = default;
+        program_header_decoder(program_header_decoder&&) = default;
+
+        inline void decode(const std::uint8_t* data, std::size_t index, ProgramHeaderEntry& value_out)
+        {
+            decodeProgramHeader(data + (elementSize * index), elementSize, el_class, value_out);
+        }
+    };
+
+
     template<typename T, typename Decoder=default_decoder<T>>
     class table_iterator : Decoder
     {
@@ -267,8 +378,15 @@ namespace elf
         std::size_t index{};
 
     public:
-        constexpr table_iterator(const std::uint8_t* data, std::size_t count, Decoder decoder = Decoder()) noexcept
-            : Decoder(decoder), data(data), count(count) { }
+        table_iterator(const std::uint8_t* data, std::size_t count, Decoder decoder = Decoder()) noexcept
+            : Decoder(decoder), data(data), count(count)
+        {
+            // Decode first entry, or use end representation if table is empty
+            if (data != nullptr && count != 0) {
+                Decoder::decode(data, 0, value);
+            }
+            else this->data = nullptr;
+        }
 
         table_iterator(const table_iterator&) = default;
         table_iterator(table_iterator&&) = default;
@@ -311,8 +429,46 @@ namespace elf
     };
 
 
+    /* Iterates the section header table.
+
+       iter_section_headers<ElfClass::class32> and <ElfClass::class64> decode entries
+       in their native layout (SectionHeader32/SectionHeader64) with the element size
+       known at compile time. The default, iter_section_headers<>, selects the class at
+       runtime and widens each entry to SectionHeader. */
+    template<ElfClass Class = ElfClass::none>
     class iter_section_headers
     {
+    private:
+        using value_type = typename class_layout<Class>::SectionHeader;
+
+        const std::uint8_t* data;
+        std::size_t header_count;
+
+    public:
+        inline constexpr iter_section_headers(const std::uint8_t* data, Header header)
+            : data(data + header.e_shoff), header_count(header.e_shnum) { }
+
+        inline constexpr iter_section_headers(const std::uint8_t* data, std::size_t header_count)
+            : data(data), header_count(header_count) { }
+
+        iter_section_headers(const iter_section_headers&) = default;
+        iter_section_headers(iter_section_headers&&) = default;
+        iter_section_headers& operator =(const iter_section_headers&) = default;
+        iter_section_headers& operator =(iter_section_headers&&) = default;
+
+        inline auto begin() {
+            return table_iterator<value_type>(data, header_count);
+        }
+
+        inline auto end() {
+            return table_iterator<value_type>(nullptr, header_count);
+        }
+    };
+
+
+    template<>
+    class iter_section_headers<ElfClass::none>
+    {
     private:
         const std::uint8_t* data;
         std::size_t header_count;
@@ -343,9 +499,47 @@ namespace elf
         }
     };
 
+    iter_section_headers(const std::uint8_t*, Header) -> iter_section_headers<>;
+    iter_section_headers(const std::uint8_t*, std::size_t, ElfClass) -> iter_section_headers<>;
 
+
+    /* Iterates a symbol table. As with iter_section_headers, iter_symbols<ElfClass::class32>
+       and <ElfClass::class64> yield the native entry layout, while iter_symbols<> selects
+       the class at runtime and widens each entry to SymbolTableEntry. */
+    template<ElfClass Class = ElfClass::none>
     class iter_symbols
     {
+    private:
+        using value_type = typename class_layout<Class>::SymbolTableEntry;
+
+        const std::uint8_t* data{};
+        std::size_t entry_count{};
+
+    public:
+        inline constexpr iter_symbols(const std::uint8_t* data, SectionHeader section)
+            : iter_symbols(data + section.sh_offset, section.sh_size / sizeof(value_type)) { }
+
+        inline constexpr iter_symbols(const std::uint8_t* data, std::size_t entry_count)
+            : data(data), entry_count(entry_count) { }
+
+        iter_symbols(const iter_symbols&) = default;
+        iter_symbols(iter_symbols&&) = default;
+        iter_symbols& operator =(const iter_symbols&) = default;
+        iter_symbols& operator =(iter_symbols&&) = default;
+
+        inline auto begin() {
+            return table_iterator<value_type>(data, entry_count);
+        }
+
+        inline auto end() {
+            return table_iterator<value_type>(nullptr, entry_count);
+        }
+    };
+
+
+    template<>
+    class iter_symbols<ElfClass::none>
+    {
     private:
         const std::uint8_t* data{};
         std::size_t entry_count{};
@@ -378,4 +572,78 @@ namespace elf
                 nullptr, entry_count, symbol_table_decoder(el_class));
         }
     };
+
+    iter_symbols(const std::uint8_t*, SectionHeader, ElfClass) -> iter_symbols<>;
+    iter_symbols(const std::uint8_t*, std::size_t, ElfClass) -> iter_symbols<>;
+
+
+    /* Iterates the program header table. iter_program_headers<ElfClass::class32> and
+       <ElfClass::class64> yield the native entry layout; iter_program_headers<> selects
+       the class at runtime. */
+    template<ElfClass Class = ElfClass::none>
+    class iter_program_headers
+    {
+    private:
+        using value_type = typename class_layout<Class>::ProgramHeaderEntry;
+
+        const std::uint8_t* data;
+        std::size_t header_count;
+
+    public:
+        inline constexpr iter_program_headers(const std::uint8_t* data, Header header)
+            : data(data + header.e_phoff), header_count(header.e_phnum) { }
+
+        inline constexpr iter_program_headers(const std::uint8_t* data, std::size_t header_count)
+            : data(data), header_count(header_count) { }
+
+        iter_program_headers(const iter_program_headers&) = default;
+        iter_program_headers(iter_program_headers&&) = default;
+        iter_program_headers& operator =(const iter_program_headers&) = default;
+        iter_program_headers& operator =(iter_program_headers&&) = default;
+
+        inline auto begin() {
+            return table_iterator<value_type>(data, header_count);
+        }
+
+        inline auto end() {
+            return table_iterator<value_type>(nullptr, header_count);
+        }
+    };
+
+
+    template<>
+    class iter_program_headers<ElfClass::none>
+    {
+    private:
+        const std::uint8_t* data;
+        std::size_t header_count;
+        ElfClass el_class;
+
+    public:
+        inline constexpr iter_program_headers(const std::uint8_t* data, Header header)
+            : data(data + header.e_phoff), header_count(header.e_phnum), el_class(header.el_class()) { }
+
+        inline constexpr iter_program_headers(const std::uint8_t* data, std::size_t header_count, ElfClass el_class)
+            : data(data), header_count(header_count), el_class(el_class) { }
+
+        iter_program_headers(const iter_program_headers&) = default;
+        iter_program_headers(iter_program_headers&&) = default;
+        iter_program_headers& operator =(const iter_program_headers&) = default;
+        iter_program_headers& operator =(iter_program_headers&&) = default;
+
+        inline auto begin()
+        {
+            return table_iterator<ProgramHeaderEntry, program_header_decoder>(
+                data, header_count, program_header_decoder(el_class));
+        }
+
+        inline auto end()
+        {
+            return table_iterator<ProgramHeaderEntry, program_header_decoder>(
+                nullptr, header_count, program_header_decoder(el_class));
+        }
+    };
+
+    iter_program_headers(const std::uint8_t*, Header) -> iter_program_headers<>;
+    iter_program_headers(const std::uint8_t*, std::size_t, ElfClass) -> iter_program_headers<>;
 }
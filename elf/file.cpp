@@ -0,0 +1,428 @@
+/* file.cpp - (c) James S Renwick 2020 */
+#include <cstring>
+#include <algorithm>
+#include <climits>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <zlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "file.hpp"
+
+#define SHN_UNDEF  0x0000
+#define SHN_XINDEX 0xFFFF
+#define PN_XNUM    0xFFFF
+
+
+namespace elf
+{
+    void SectionNameIndex::build(const SectionHeader* headers, std::size_t count, SectionView shstrtab)
+    {
+        clear();
+        if (count == 0 || count >= emptySlot) return;
+
+        // Size table to a power of two at most half full
+        std::size_t capacity = 8;
+        while (capacity < count * 2) capacity <<= 1;
+
+        slots.assign(capacity, Slot{ 0, {}, emptySlot });
+        mask = capacity - 1;
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            if (headers[i].sh_name >= shstrtab.size) continue;
+            std::string_view name(reinterpret_cast<const char*>(shstrtab.data + headers[i].sh_name));
+
+            auto hash = SectionNameIndex::hash(name);
+            for (std::size_t slot = hash & mask; ; slot = (slot + 1) & mask)
+            {
+                if (slots[slot].index == emptySlot) {
+                    slots[slot] = Slot{ hash, name, static_cast<std::uint32_t>(i) };
+                    break;
+                }
+                // Keep the first section of a given name
+                if (slots[slot].hash == hash && slots[slot].name == name) break;
+            }
+        }
+    }
+
+    void SectionNameIndex::clear() noexcept
+    {
+        slots.clear();
+        mask = 0;
+    }
+
+    bool SectionNameIndex::find(std::string_view name, std::size_t& index_out) const noexcept
+    {
+        if (slots.empty()) return false;
+
+        auto hash = SectionNameIndex::hash(name);
+        for (std::size_t slot = hash & mask; slots[slot].index != emptySlot; slot = (slot + 1) & mask)
+        {
+            if (slots[slot].hash == hash && slots[slot].name == name) {
+                index_out = slots[slot].index;
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+
+    struct ElfFile::SectionCache
+    {
+        struct Entry
+        {
+            std::once_flag once{};
+            std::unique_ptr<std::uint8_t[]> data{};
+            std::size_t size{};
+        };
+
+        std::mutex mutex{};
+        std::unordered_map<std::size_t, std::unique_ptr<Entry>> entries{};
+    };
+
+
+    static bool _inflate(const std::uint8_t* data, std::size_t size, std::uint8_t* out, std::size_t outSize)
+    {
+        z_stream stream{};
+        if (inflateInit(&stream) != Z_OK) return false;
+
+        stream.next_in = const_cast<Bytef*>(data);
+        stream.next_out = out;
+
+        // zlib counts in 32-bit units, so feed large buffers in chunks
+        int result;
+        while (true)
+        {
+            if (stream.avail_in == 0 && size != 0) {
+                stream.avail_in = static_cast<uInt>(std::min<std::size_t>(size, UINT_MAX));
+                size -= stream.avail_in;
+            }
+            if (stream.avail_out == 0 && outSize != 0) {
+                stream.avail_out = static_cast<uInt>(std::min<std::size_t>(outSize, UINT_MAX));
+                outSize -= stream.avail_out;
+            }
+            result = inflate(&stream, Z_NO_FLUSH);
+            if (result != Z_OK) break;
+        }
+        inflateEnd(&stream);
+
+        // Must end exactly at the expected size
+        return result == Z_STREAM_END && stream.avail_out == 0 && outSize == 0;
+    }
+
+
+    static bool _decompress(SectionView raw, const SectionHeader& header, ElfClass el_class,
+                            std::unique_ptr<std::uint8_t[]>& data_out, std::size_t& size_out)
+    {
+        const std::uint8_t* payload;
+        std::size_t payloadSize;
+        std::uint64_t size;
+
+        if (header.sh_flags & SHF_COMPRESSED)
+        {
+            CompressionHeader chdr; std::size_t chdrSize;
+            if (!decodeCompressionHeader(raw.data, raw.size, el_class, chdr, chdrSize)) return false;
+            if (chdr.ch_type != CompressionType::Zlib) return false;
+
+            payload = raw.data + chdrSize; payloadSize = raw.size - chdrSize;
+            size = chdr.ch_size;
+        }
+        // Legacy .zdebug sections: "ZLIB" followed by the big-endian 64-bit size
+        else
+        {
+            if (raw.size < 12 || std::memcmp(raw.data, "ZLIB", 4) != 0) return false;
+
+            size = 0;
+            for (int i = 4; i < 12; i++) size = (size << 8) | raw.data[i];
+            payload = raw.data + 12; payloadSize = raw.size - 12;
+        }
+
+        // Reject sizes beyond DEFLATE's maximum ratio before allocating
+        if (size == 0 || size / 1032 > payloadSize) return false;
+
+        std::unique_ptr<std::uint8_t[]> data(new std::uint8_t[size]);
+        if (!_inflate(payload, payloadSize, data.get(), size)) return false;
+
+        data_out = std::move(data);
+        size_out = size;
+        return true;
+    }
+
+
+
+    ElfFile::ElfFile() = default;
+
+    ElfFile::~ElfFile()
+    {
+        close();
+    }
+
+    ElfFile::ElfFile(ElfFile&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    ElfFile& ElfFile::operator =(ElfFile&& other) noexcept
+    {
+        if (this == &other) return *this;
+        close();
+
+        _data = other._data; _size = other._size; _mapped = other._mapped;
+        _header = other._header;
+        _sectionCount = other._sectionCount;
+        _programHeaderCount = other._programHeaderCount;
+        _shstrtab = other._shstrtab;
+        _sections = std::move(other._sections);
+        _sectionIndex = std::move(other._sectionIndex);
+        _cache = std::move(other._cache);
+
+        other._data = nullptr; other._size = 0; other._mapped = false;
+        other.close();
+        return *this;
+    }
+
+
+    bool ElfFile::open(const char* filepath)
+    {
+        close();
+
+        int fd = ::open(filepath, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+            ::close(fd); return false;
+        }
+
+        // The mapping remains valid after the descriptor is closed
+        void* mapping = ::mmap(nullptr, static_cast<std::size_t>(info.st_size),
+                               PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) return false;
+
+        if (!load(static_cast<const std::uint8_t*>(mapping), static_cast<std::size_t>(info.st_size)))
+        {
+            ::munmap(mapping, static_cast<std::size_t>(info.st_size));
+            return false;
+        }
+        _mapped = true;
+        return true;
+    }
+
+
+    bool ElfFile::load(const std::uint8_t* data, std::size_t size)
+    {
+        close();
+        if (data == nullptr || size < EI_NIDENT) return false;
+
+        Header header;
+        if (!decodeElfHeader(data, size, header)) return false;
+
+        _data = data; _size = size; _header = header;
+
+        // Determine section count, handling extended numbering where the real
+        // count and string table index are held in the first section header
+        std::size_t entrySize = el_class() == ElfClass::class64 ?
+            sizeof(SectionHeader64) : sizeof(SectionHeader32);
+
+        std::size_t count = header.e_shnum;
+        std::size_t shstrndx = header.e_shstrndx;
+        std::size_t phnum = header.e_phnum;
+
+        if (header.e_shoff != 0)
+        {
+            SectionHeader first;
+            if (!view(header.e_shoff, entrySize) ||
+                !decodeSectionHeader(data + header.e_shoff, entrySize, el_class(), first))
+            {
+                close(); return false;
+            }
+            if (count == SHN_UNDEF) count = first.sh_size;
+            if (shstrndx == SHN_XINDEX) shstrndx = first.sh_link;
+            if (phnum == PN_XNUM) phnum = first.sh_info;
+        }
+        else count = 0;
+
+        // Check section header table lies within the file
+        if (count != 0 && (count > _size / entrySize || !view(header.e_shoff, count * entrySize)))
+        {
+            close(); return false;
+        }
+        _sectionCount = count;
+
+        // Check program header table lies within the file, otherwise ignore it
+        std::size_t phentsize = el_class() == ElfClass::class64 ?
+            sizeof(ProgramHeaderEntry64) : sizeof(ProgramHeaderEntry32);
+
+        if (header.e_phoff != 0 && phnum <= _size / phentsize && view(header.e_phoff, phnum * phentsize)) {
+            _programHeaderCount = phnum;
+        }
+
+        // Decode section header table once, selecting the entry layout once for the table
+        _sections.resize(count);
+        dispatch_class(el_class(), [&](auto el_class)
+        {
+            std::size_t index = 0;
+            for (const auto& section : iter_section_headers<el_class>(data + header.e_shoff, count))
+            {
+                SectionHeader& header_out = _sections[index++];
+                header_out.sh_name = section.sh_name;
+                header_out.sh_type = section.sh_type;
+                header_out.sh_flags = section.sh_flags;
+                header_out.sh_addr = section.sh_addr;
+                header_out.sh_offset = section.sh_offset;
+                header_out.sh_size = section.sh_size;
+                header_out.sh_link = section.sh_link;
+                header_out.sh_info = section.sh_info;
+                header_out.sh_addralign = section.sh_addralign;
+                header_out.sh_entsize = section.sh_entsize;
+            }
+        });
+
+        // Locate section name string table. Require it to be null-terminated so that
+        // any name within its bounds is also terminated.
+        SectionView shstrtab = section(shstrndx);
+        if (shstrtab.size != 0 && shstrtab.data[shstrtab.size - 1] == '\0') {
+            _shstrtab = shstrtab;
+        }
+
+        _sectionIndex.build(_sections.data(), _sections.size(), _shstrtab);
+        _cache.reset(new SectionCache());
+        return true;
+    }
+
+
+    void ElfFile::close() noexcept
+    {
+        if (_mapped) {
+            ::munmap(const_cast<std::uint8_t*>(_data), _size);
+        }
+        _data = nullptr; _size = 0; _mapped = false;
+        _header = Header{};
+        _sectionCount = 0;
+        _programHeaderCount = 0;
+        _shstrtab = SectionView{};
+        _sections.clear();
+        _sectionIndex.clear();
+        _cache.reset();
+    }
+
+
+    SectionView ElfFile::view(std::uint64_t offset, std::uint64_t size) const noexcept
+    {
+        if (offset > _size || size > _size - offset) return SectionView{};
+        return SectionView{ _data + offset, static_cast<std::size_t>(size) };
+    }
+
+
+    bool ElfFile::sectionHeader(std::size_t index, SectionHeader& header_out) const noexcept
+    {
+        if (index >= _sections.size()) return false;
+
+        header_out = _sections[index];
+        return true;
+    }
+
+    bool ElfFile::sectionHeader(std::string_view name, SectionHeader& header_out) const noexcept
+    {
+        std::size_t index;
+        if (!_sectionIndex.find(name, index)) return false;
+
+        header_out = _sections[index];
+        return true;
+    }
+
+
+    const char* ElfFile::sectionName(const SectionHeader& section) const noexcept
+    {
+        if (section.sh_name >= _shstrtab.size) return nullptr;
+        return reinterpret_cast<const char*>(_shstrtab.data + section.sh_name);
+    }
+
+
+    SectionView ElfFile::section(const SectionHeader& section) const noexcept
+    {
+        if (section.sh_type == SectionType::NoBits || section.sh_type == SectionType::Null) {
+            return SectionView{};
+        }
+        return view(section.sh_offset, section.sh_size);
+    }
+
+    SectionView ElfFile::section(std::size_t index) const noexcept
+    {
+        SectionHeader header;
+        if (!sectionHeader(index, header)) return SectionView{};
+        return section(header);
+    }
+
+    SectionView ElfFile::section(std::string_view name) const noexcept
+    {
+        SectionHeader header;
+        if (!sectionHeader(name, header)) return SectionView{};
+        return section(header);
+    }
+
+
+    bool ElfFile::isCompressed(const SectionHeader& section) const noexcept
+    {
+        if (section.sh_flags & SHF_COMPRESSED) return true;
+
+        const char* name = sectionName(section);
+        return name != nullptr && std::strncmp(name, ".zdebug", 7) == 0;
+    }
+
+
+    SectionView ElfFile::sectionData(std::size_t index) const
+    {
+        SectionHeader header;
+        if (!sectionHeader(index, header)) return SectionView{};
+
+        SectionView raw = section(header);
+        if (!raw || !isCompressed(header)) return raw;
+
+        // Find or create the cache entry, then inflate outside the lock so
+        // that different sections can be decompressed concurrently
+        SectionCache::Entry* entry;
+        {
+            std::lock_guard<std::mutex> lock(_cache->mutex);
+            auto& slot = _cache->entries[index];
+            if (!slot) slot.reset(new SectionCache::Entry());
+            entry = slot.get();
+        }
+        std::call_once(entry->once, [&]() {
+            _decompress(raw, header, el_class(), entry->data, entry->size);
+        });
+
+        if (!entry->data) return SectionView{};
+        return SectionView{ entry->data.get(), entry->size };
+    }
+
+    SectionView ElfFile::sectionData(std::string_view name) const
+    {
+        std::size_t index;
+        if (!_sectionIndex.find(name, index)) return SectionView{};
+        return sectionData(index);
+    }
+
+
+    bool ElfFile::programHeader(std::size_t index, ProgramHeaderEntry& header_out) const noexcept
+    {
+        if (index >= _programHeaderCount) return false;
+
+        std::size_t entrySize = el_class() == ElfClass::class64 ?
+            sizeof(ProgramHeaderEntry64) : sizeof(ProgramHeaderEntry32);
+
+        return decodeProgramHeader(_data + _header.e_phoff + (index * entrySize),
+                                   entrySize, el_class(), header_out);
+    }
+
+    SectionView ElfFile::segment(const ProgramHeaderEntry& segment) const noexcept
+    {
+        return view(segment.p_offset, segment.p_filesz);
+    }
+}
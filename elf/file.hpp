@@ -0,0 +1,232 @@
+/* file.hpp - (c) James S Renwick 2020 */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "elf.hpp"
+
+
+namespace elf
+{
+    /* Non-owning, bounds-checked view over a range of bytes within an ELF file. */
+    struct SectionView
+    {
+        const std::uint8_t* data{};
+        std::size_t size{};
+
+    public:
+        inline constexpr operator bool() const noexcept {
+            return data != nullptr;
+        }
+        inline constexpr const std::uint8_t* begin() const noexcept {
+            return data;
+        }
+        inline constexpr const std::uint8_t* end() const noexcept {
+            return data + size;
+        }
+    };
+
+
+    /* Hash index mapping section names to section header table indices. Built once over
+       the section table; lookups hash the name once and compare precomputed hashes before
+       comparing strings. Where several sections share a name, the first is indexed. */
+    class SectionNameIndex
+    {
+    private:
+        struct Slot
+        {
+            std::uint64_t hash{};
+            std::string_view name{};
+            std::uint32_t index{};
+        };
+        static constexpr std::uint32_t emptySlot = static_cast<std::uint32_t>(-1);
+
+        std::vector<Slot> slots{};
+        std::size_t mask{};
+
+    public:
+        /* FNV-1a hash of the given name. */
+        static inline std::uint64_t hash(std::string_view name) noexcept
+        {
+            std::uint64_t value = 0xcbf29ce484222325ull;
+            for (unsigned char c : name) {
+                value = (value ^ c) * 0x100000001b3ull;
+            }
+            return value;
+        }
+
+        /* Indexes the given section headers, with names drawn from the given
+           null-terminated section name string table. */
+        void build(const SectionHeader* headers, std::size_t count, SectionView shstrtab);
+
+        void clear() noexcept;
+
+        /* Finds the index of the first section with the given name. */
+        bool find(std::string_view name, std::size_t& index_out) const noexcept;
+
+        inline bool empty() const noexcept {
+            return slots.empty();
+        }
+    };
+
+
+    /* An ELF file whose contents are memory-mapped read-only. The section header table is
+       decoded and indexed by name once on load; section contents are viewed directly in
+       the mapping and nothing is copied unless the caller does so explicitly. */
+    class ElfFile
+    {
+    private:
+        const std::uint8_t* _data{};
+        std::size_t _size{};
+        bool _mapped{};
+
+        Header _header{};
+        std::size_t _sectionCount{};
+        std::size_t _programHeaderCount{};
+        SectionView _shstrtab{};
+
+        // Decoded section header table and name index, built once on load
+        std::vector<SectionHeader> _sections{};
+        SectionNameIndex _sectionIndex{};
+
+        // Uncompressed contents of compressed sections, inflated on first access
+        struct SectionCache;
+        std::unique_ptr<SectionCache> _cache{};
+
+    public:
+        ElfFile();
+        ~ElfFile();
+
+        ElfFile(const ElfFile&) = delete;
+        ElfFile& operator =(const ElfFile&) = delete;
+        ElfFile(ElfFile&& other) noexcept;
+        ElfFile& operator =(ElfFile&& other) noexcept;
+
+    public:
+        /* Maps the file at the given path and validates its headers.
+           Returns false if the file could not be mapped or is not a valid ELF file. */
+        bool open(const char* filepath);
+
+        /* Uses the given buffer as the file contents without taking ownership.
+           The buffer must outlive this object. */
+        bool load(const std::uint8_t* data, std::size_t size);
+
+        /* Unmaps the file (if mapped) and resets this object. */
+        void close() noexcept;
+
+    public:
+        inline bool isOpen() const noexcept {
+            return _data != nullptr;
+        }
+        inline const Header& header() const noexcept {
+            return _header;
+        }
+        inline ElfClass el_class() const noexcept {
+            return _header.el_class();
+        }
+        inline const std::uint8_t* data() const noexcept {
+            return _data;
+        }
+        inline std::size_t size() const noexcept {
+            return _size;
+        }
+        /* Gets the number of entries in the section header table, accounting for
+           extended section numbering. */
+        inline std::size_t sectionCount() const noexcept {
+            return _sectionCount;
+        }
+
+        /* Gets the number of entries in the program header table, accounting for
+           extended numbering. */
+        inline std::size_t programHeaderCount() const noexcept {
+            return _programHeaderCount;
+        }
+
+        /* Returns a view over [offset, offset + size) of the file, or an empty view
+           if the range lies outside the file. */
+        SectionView view(std::uint64_t offset, std::uint64_t size) const noexcept;
+
+        bool sectionHeader(std::size_t index, SectionHeader& header_out) const noexcept;
+        bool sectionHeader(std::string_view name, SectionHeader& header_out) const noexcept;
+
+        /* Finds the index of the first section with the given name in O(1) expected time. */
+        inline bool sectionIndex(std::string_view name, std::size_t& index_out) const noexcept {
+            return _sectionIndex.find(name, index_out);
+        }
+        inline const SectionNameIndex& sectionNameIndex() const noexcept {
+            return _sectionIndex;
+        }
+
+        /* Gets the name of the given section from the section name string table,
+           or nullptr if it has none. */
+        const char* sectionName(const SectionHeader& section) const noexcept;
+
+        /* Gets a view over the contents of the given section. SHT_NOBITS sections
+           and sections extending past the end of the file produce an empty view. */
+        SectionView section(const SectionHeader& section) const noexcept;
+        SectionView section(std::size_t index) const noexcept;
+        SectionView section(std::string_view name) const noexcept;
+
+        /* Whether the contents of the given section are compressed, either flagged
+           SHF_COMPRESSED or as a legacy GNU .zdebug_* section. */
+        bool isCompressed(const SectionHeader& section) const noexcept;
+
+        /* Gets the uncompressed contents of the given section. Compressed sections are
+           inflated on first access and the result cached until the file is closed; other
+           sections are viewed directly in the mapping. Safe to call concurrently.
+           Returns an empty view if the section cannot be decompressed. */
+        SectionView sectionData(std::size_t index) const;
+        SectionView sectionData(std::string_view name) const;
+
+        bool programHeader(std::size_t index, ProgramHeaderEntry& header_out) const noexcept;
+
+        /* Gets a view over the file contents of the given segment (p_filesz bytes). */
+        SectionView segment(const ProgramHeaderEntry& segment) const noexcept;
+
+    public:
+        /* Iterates the section header table. Given a class template argument, entries are
+           decoded in that class's native layout; the iteration is empty if the file is of
+           a different class. See dispatch_class. */
+        template<ElfClass Class = ElfClass::none>
+        inline iter_section_headers<Class> sectionHeaders() const noexcept
+        {
+            const std::uint8_t* table = _sectionCount != 0 ? _data + _header.e_shoff : nullptr;
+
+            if constexpr (Class == ElfClass::none) {
+                return iter_section_headers<>(table, _sectionCount, el_class());
+            }
+            else return iter_section_headers<Class>(Class == el_class() ? table : nullptr, _sectionCount);
+        }
+
+        /* Iterates the program header table, as with sectionHeaders. */
+        template<ElfClass Class = ElfClass::none>
+        inline iter_program_headers<Class> programHeaders() const noexcept
+        {
+            const std::uint8_t* table = _programHeaderCount != 0 ? _data + _header.e_phoff : nullptr;
+
+            if constexpr (Class == ElfClass::none) {
+                return iter_program_headers<>(table, _programHeaderCount, el_class());
+            }
+            else return iter_program_headers<Class>(Class == el_class() ? table : nullptr, _programHeaderCount);
+        }
+
+        /* Iterates the symbols of the given SHT_SYMTAB/SHT_DYNSYM section, as with sectionHeaders. */
+        template<ElfClass Class = ElfClass::none>
+        inline iter_symbols<Class> symbols(const SectionHeader& section) const noexcept
+        {
+            std::size_t entrySize = el_class() == ElfClass::class64 ?
+                sizeof(SymbolTableEntry64) : sizeof(SymbolTableEntry32);
+
+            SectionView contents = this->section(section);
+            if (contents.size < entrySize) contents = SectionView{};
+
+            if constexpr (Class == ElfClass::none) {
+                return iter_symbols<>(contents.data, contents.size / entrySize, el_class());
+            }
+            else return iter_symbols<Class>(Class == el_class() ? contents.data : nullptr, contents.size / entrySize);
+        }
+    };
+}
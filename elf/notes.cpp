@@ -0,0 +1,95 @@
+/* notes.cpp - (c) James S Renwick 2020 */
+#include <cstring>
+#include "notes.hpp"
+
+
+namespace elf
+{
+    iter_notes::iterator::iterator(const std::uint8_t* data, std::size_t size, std::size_t alignment) noexcept
+        : data(data), size(size), alignment(alignment)
+    {
+        if (!decode()) { this->data = nullptr; this->offset = 0; }
+    }
+
+
+    iter_notes::iterator& iter_notes::iterator::operator++() noexcept
+    {
+        offset = next;
+        // Use null data & zero offset to indicate end
+        if (!decode()) { data = nullptr; offset = 0; }
+        return *this;
+    }
+
+
+    bool iter_notes::iterator::decode() noexcept
+    {
+        if (data == nullptr || offset >= size || size - offset < sizeof(NoteHeader)) return false;
+
+        NoteHeader header;
+        std::memcpy(&header, data + offset, sizeof(header));
+
+        auto align = [this](std::uint64_t value) { return (value + alignment - 1) & ~std::uint64_t(alignment - 1); };
+
+        std::uint64_t nameOffset = offset + sizeof(NoteHeader);
+        std::uint64_t descOffset = nameOffset + align(header.n_namesz);
+        std::uint64_t end = descOffset + align(header.n_descsz);
+
+        if (descOffset + header.n_descsz > size) return false;
+
+        // Exclude the name's terminator
+        std::size_t nameSize = header.n_namesz;
+        if (nameSize != 0 && data[nameOffset + nameSize - 1] == '\0') nameSize--;
+
+        value.type = header.n_type;
+        value.name = std::string_view(reinterpret_cast<const char*>(data + nameOffset), nameSize);
+        value.desc = SectionView{ data + descOffset, header.n_descsz };
+
+        next = end > size ? size : static_cast<std::size_t>(end);
+        return true;
+    }
+
+
+    static bool _findBuildId(SectionView notes, std::size_t alignment, SectionView& buildId_out)
+    {
+        for (const Note& note : iter_notes(notes, alignment))
+        {
+            if (note.type == static_cast<std::uint32_t>(GnuNoteType::BuildId) &&
+                note.name == "GNU" && note.desc.size != 0)
+            {
+                buildId_out = note.desc;
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+    bool readBuildId(const ElfFile& file, SectionView& buildId_out)
+    {
+        for (const ProgramHeaderEntry& segment : file.programHeaders())
+        {
+            if (segment.p_type == SegmentType::Note &&
+                _findBuildId(file.segment(segment), segment.p_align, buildId_out)) return true;
+        }
+        for (const SectionHeader& section : file.sectionHeaders())
+        {
+            if (section.sh_type == SectionType::Note &&
+                _findBuildId(file.section(section), section.sh_addralign, buildId_out)) return true;
+        }
+        return false;
+    }
+
+
+    std::string formatBuildId(SectionView buildId)
+    {
+        static const char digits[] = "0123456789abcdef";
+
+        std::string result(buildId.size * 2, '\0');
+        for (std::size_t i = 0; i < buildId.size; i++)
+        {
+            result[i * 2] = digits[buildId.data[i] >> 4];
+            result[i * 2 + 1] = digits[buildId.data[i] & 0xF];
+        }
+        return result;
+    }
+}
@@ -0,0 +1,114 @@
+/* notes.hpp - (c) James S Renwick 2020 */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include "elf.hpp"
+#include "file.hpp"
+
+
+namespace elf
+{
+    /* Note entry header. Identical for both ELF classes. */
+    struct __attribute__((packed)) NoteHeader
+    {
+        std::uint32_t n_namesz; // Size of name including terminator
+        std::uint32_t n_descsz; // Size of descriptor
+        std::uint32_t n_type;   // Note type, interpreted according to name
+    };
+    static_assert(sizeof(NoteHeader) == 12, "");
+
+
+    /* Note types defined for the "GNU" owner. */
+    enum class GnuNoteType : std::uint32_t
+    {
+        AbiTag      = 1, // NT_GNU_ABI_TAG
+        HwCap       = 2, // NT_GNU_HWCAP
+        BuildId     = 3, // NT_GNU_BUILD_ID
+        GoldVersion = 4, // NT_GNU_GOLD_VERSION
+        Property    = 5  // NT_GNU_PROPERTY_TYPE_0
+    };
+
+
+    /* A decoded note. Name and descriptor point into the note section or segment. */
+    struct Note
+    {
+        std::uint32_t type{};
+        std::string_view name{};   // Owner name, excluding terminator
+        SectionView desc{};
+    };
+
+
+    /* Iterates the notes within a SHT_NOTE section or PT_NOTE segment. Iteration stops
+       at the first malformed entry. */
+    class iter_notes
+    {
+    public:
+        class iterator
+        {
+        public:
+            using difference_type = std::size_t;
+            using value_type = Note;
+            using pointer = const Note*;
+            using reference = const Note&;
+            using iterator_category = std::input_iterator_tag;
+
+        private:
+            const std::uint8_t* data{};
+            std::size_t size{};
+            std::size_t alignment{};
+            std::size_t offset{};
+            std::size_t next{};
+            Note value{};
+
+        public:
+            iterator() = default;
+            iterator(const std::uint8_t* data, std::size_t size, std::size_t alignment) noexcept;
+
+            inline reference operator*() const noexcept {
+                return value;
+            }
+            inline pointer operator->() const noexcept {
+                return &value;
+            }
+            inline bool operator!=(const iterator& other) const noexcept {
+                return data != other.data || offset != other.offset;
+            }
+            inline bool operator==(const iterator& other) const noexcept {
+                return data == other.data && offset == other.offset;
+            }
+            iterator& operator++() noexcept;
+
+        private:
+            bool decode() noexcept;
+        };
+
+    private:
+        SectionView notes{};
+        std::size_t alignment{};
+
+    public:
+        /* Notes are aligned to 4 bytes, except in sections/segments aligned to 8
+           (e.g. .note.gnu.property), where they are aligned to 8. */
+        inline iter_notes(SectionView notes, std::size_t alignment = 4) noexcept
+            : notes(notes), alignment(alignment == 8 ? 8 : 4) { }
+
+        inline iterator begin() const noexcept {
+            return iterator(notes.data, notes.size, alignment);
+        }
+        inline iterator end() const noexcept {
+            return iterator();
+        }
+    };
+
+
+    /* Finds the NT_GNU_BUILD_ID note of the given file, searching PT_NOTE segments
+       and then SHT_NOTE sections. The returned view points into the file. */
+    bool readBuildId(const ElfFile& file, SectionView& buildId_out);
+
+    /* Formats a build-ID as lowercase hexadecimal. */
+    std::string formatBuildId(SectionView buildId);
+}
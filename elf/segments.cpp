@@ -0,0 +1,159 @@
+/* segments.cpp - (c) James S Renwick 2020 */
+#include <algorithm>
+#include <unistd.h>
+#include "segments.hpp"
+
+
+namespace elf
+{
+    bool SegmentMap::build(const ElfFile& file)
+    {
+        clear();
+
+        for (const ProgramHeaderEntry& header : file.programHeaders())
+        {
+            if (header.p_type != SegmentType::Load || header.p_memsz == 0) continue;
+
+            segments.push_back(LoadSegment{ header.p_vaddr, header.p_memsz,
+                header.p_offset, std::min(header.p_filesz, header.p_memsz), header.p_align,
+                static_cast<std::uint32_t>(header.p_flags) });
+        }
+        if (segments.empty()) return false;
+
+        // Mappings are page-aligned, whatever the (possibly larger) segment alignment
+        long page = ::sysconf(_SC_PAGESIZE);
+        pageSize = page > 0 ? static_cast<std::uint64_t>(page) : 4096;
+
+        std::sort(segments.begin(), segments.end(), [](const LoadSegment& a, const LoadSegment& b) {
+            return a.vaddr < b.vaddr;
+        });
+
+        byOffset.resize(segments.size());
+        for (std::size_t i = 0; i < segments.size(); i++) {
+            byOffset[i] = static_cast<std::uint32_t>(i);
+        }
+        std::sort(byOffset.begin(), byOffset.end(), [this](std::uint32_t a, std::uint32_t b) {
+            return segments[a].offset < segments[b].offset;
+        });
+        return true;
+    }
+
+
+    void SegmentMap::clear() noexcept
+    {
+        segments.clear();
+        byOffset.clear();
+    }
+
+
+    std::uint64_t SegmentMap::imageBase() const noexcept
+    {
+        if (segments.empty()) return 0;
+
+        auto& first = segments.front();
+        return first.align > 1 ? first.vaddr & ~(first.align - 1) : first.vaddr;
+    }
+
+
+    bool SegmentMap::findAddress(std::uint64_t vaddr, std::size_t& index_out) const noexcept
+    {
+        // Find last segment starting at or below the address
+        auto it = std::upper_bound(segments.begin(), segments.end(), vaddr,
+            [](std::uint64_t vaddr, const LoadSegment& segment) { return vaddr < segment.vaddr; });
+        if (it == segments.begin()) return false;
+        --it;
+
+        if (vaddr - it->vaddr >= it->memsz) return false;
+        index_out = static_cast<std::size_t>(it - segments.begin());
+        return true;
+    }
+
+
+    bool SegmentMap::findOffset(std::uint64_t offset, std::size_t& index_out) const noexcept
+    {
+        auto it = std::upper_bound(byOffset.begin(), byOffset.end(), offset,
+            [this](std::uint64_t offset, std::uint32_t index) { return offset < segments[index].offset; });
+        if (it == byOffset.begin()) return false;
+        --it;
+
+        auto& segment = segments[*it];
+        if (offset - segment.offset >= segment.filesz) return false;
+        index_out = *it;
+        return true;
+    }
+
+
+    bool SegmentMap::fileOffset(std::uint64_t vaddr, std::uint64_t& offset_out) const noexcept
+    {
+        std::size_t index;
+        if (!findAddress(vaddr, index)) return false;
+
+        auto& segment = segments[index];
+        auto delta = vaddr - segment.vaddr;
+        if (delta >= segment.filesz) return false;
+
+        offset_out = segment.offset + delta;
+        return true;
+    }
+
+
+    bool SegmentMap::virtualAddress(std::uint64_t offset, std::uint64_t& vaddr_out) const noexcept
+    {
+        std::size_t index;
+        if (!findOffset(offset, index)) return false;
+
+        vaddr_out = segments[index].vaddr + (offset - segments[index].offset);
+        return true;
+    }
+
+
+    static std::uint32_t _permissionFlags(const char* permissions) noexcept
+    {
+        std::uint32_t flags = 0;
+        for (; *permissions != '\0'; permissions++)
+        {
+            switch (*permissions)
+            {
+                case 'r': flags |= 1u << static_cast<std::uint32_t>(SegmentFlags::Readable); break;
+                case 'w': flags |= 1u << static_cast<std::uint32_t>(SegmentFlags::Writable); break;
+                case 'x': flags |= 1u << static_cast<std::uint32_t>(SegmentFlags::Executable); break;
+            }
+        }
+        return flags;
+    }
+
+
+    bool SegmentMap::loadBias(std::uint64_t mappingStart, std::uint64_t mappingOffset,
+                              std::int64_t& bias_out) const noexcept
+    {
+        return loadBias(mappingStart, mappingOffset, nullptr, bias_out);
+    }
+
+    bool SegmentMap::loadBias(std::uint64_t mappingStart, std::uint64_t mappingOffset,
+                              const char* permissions, std::int64_t& bias_out) const noexcept
+    {
+        // Mappings start on a page boundary which may precede the segment's first
+        // byte, so match segments whose page-aligned range covers the offset
+        auto pageDown = [this](std::uint64_t offset) { return offset & ~(pageSize - 1); };
+        auto it = std::upper_bound(byOffset.begin(), byOffset.end(), mappingOffset,
+            [&](std::uint64_t offset, std::uint32_t index) { return offset < pageDown(segments[index].offset); });
+
+        // Segments may share a page, in which case prefer the one with the mapping's permissions
+        const LoadSegment* match = nullptr;
+        std::uint32_t flags = permissions != nullptr ? _permissionFlags(permissions) : 0;
+        while (it != byOffset.begin())
+        {
+            auto& segment = segments[*--it];
+            if (mappingOffset >= segment.offset + segment.filesz) continue;
+
+            if (match == nullptr) match = &segment;
+            if (permissions == nullptr || segment.flags == flags) { match = &segment; break; }
+        }
+        if (match == nullptr) return false;
+
+        // vaddr - offset is constant across the segment
+        std::uint64_t linkAddress = match->vaddr - match->offset + mappingOffset;
+        bias_out = static_cast<std::int64_t>(mappingStart - linkAddress);
+        return true;
+    }
+}
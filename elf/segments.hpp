@@ -0,0 +1,74 @@
+/* segments.hpp - (c) James S Renwick 2020 */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "elf.hpp"
+#include "file.hpp"
+
+
+namespace elf
+{
+    /* A loadable (PT_LOAD) segment. */
+    struct LoadSegment
+    {
+        std::uint64_t vaddr;  // Virtual address of first byte
+        std::uint64_t memsz;  // Size in memory
+        std::uint64_t offset; // File offset of first byte
+        std::uint64_t filesz; // Size in file (may be smaller than memsz)
+        std::uint64_t align;  // Load alignment
+        std::uint32_t flags;  // Permissions, as p_flags (bit 1 << SegmentFlags::*)
+    };
+
+
+    /* Map of the loadable segments of a file, precomputed and sorted so that virtual
+       addresses and file offsets can be translated in O(log n). */
+    class SegmentMap
+    {
+    private:
+        std::vector<LoadSegment> segments{};     // Sorted by virtual address
+        std::vector<std::uint32_t> byOffset{};   // Segment indices sorted by file offset
+        std::uint64_t pageSize{};                // Granularity of runtime mappings
+
+    public:
+        SegmentMap() = default;
+
+        /* Collects and sorts the PT_LOAD segments of the given file. */
+        bool build(const ElfFile& file);
+
+        void clear() noexcept;
+
+        inline std::size_t size() const noexcept {
+            return segments.size();
+        }
+        inline const LoadSegment& operator[](std::size_t index) const noexcept {
+            return segments[index];
+        }
+
+        /* Link-time address at which the image starts: the lowest segment
+           address rounded down to its alignment. */
+        std::uint64_t imageBase() const noexcept;
+
+        /* Finds the segment whose in-memory range contains the given address. */
+        bool findAddress(std::uint64_t vaddr, std::size_t& index_out) const noexcept;
+        /* Finds the segment whose in-file range contains the given file offset. */
+        bool findOffset(std::uint64_t offset, std::size_t& index_out) const noexcept;
+
+        /* Translates a link-time virtual address to a file offset. Fails for addresses
+           outside any segment or within zero-filled (bss) memory. */
+        bool fileOffset(std::uint64_t vaddr, std::uint64_t& offset_out) const noexcept;
+
+        /* Translates a file offset to its link-time virtual address. */
+        bool virtualAddress(std::uint64_t offset, std::uint64_t& vaddr_out) const noexcept;
+
+        /* Computes the load bias (runtime address - link-time address) from a mapping of
+           the file in a running process, as listed in /proc/<pid>/maps: the mapping's start
+           address and the (page-aligned) file offset it maps. Where segments share the
+           mapped page, the mapping's permissions (e.g. "r-xp"), if given, select between them. */
+        bool loadBias(std::uint64_t mappingStart, std::uint64_t mappingOffset,
+                      std::int64_t& bias_out) const noexcept;
+        bool loadBias(std::uint64_t mappingStart, std::uint64_t mappingOffset,
+                      const char* permissions, std::int64_t& bias_out) const noexcept;
+    };
+}
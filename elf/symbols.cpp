@@ -0,0 +1,418 @@
+/* symbols.cpp - (c) James S Renwick 2020 */
+#include <algorithm>
+#include <cstring>
+#include "symbols.hpp"
+
+#define SHN_UNDEF 0x0000
+
+
+namespace elf
+{
+    template<typename T>
+    static inline T _load(const std::uint8_t* data, std::size_t offset) noexcept
+    {
+        T value; std::memcpy(&value, data + offset, sizeof(T));
+        return value;
+    }
+
+
+    /* Decodes entries of the given layout with fixed-offset loads rather than
+       through the bitfield struct, so each field is a single load and store.
+       (GCC vectorises the loop at -O3, but not at the -O2 the library builds with.) */
+    template<typename Entry, std::size_t NameOffset, std::size_t ValueOffset, std::size_t SizeOffset,
+             std::size_t InfoOffset, std::size_t ShndxOffset>
+    static void _decode_symbol_columns(const std::uint8_t* __restrict data, std::size_t count,
+                                       SymbolColumns& columns_out)
+    {
+        using Address = decltype(Entry::st_value);
+
+        std::uint64_t* __restrict value = columns_out.value.data();
+        std::uint64_t* __restrict size = columns_out.size.data();
+        std::uint32_t* __restrict name = columns_out.name.data();
+        std::uint8_t* __restrict info = columns_out.info.data();
+        std::uint16_t* __restrict shndx = columns_out.shndx.data();
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            const std::uint8_t* entry = data + (i * sizeof(Entry));
+            name[i] = _load<std::uint32_t>(entry, NameOffset);
+            value[i] = _load<Address>(entry, ValueOffset);
+            size[i] = _load<Address>(entry, SizeOffset);
+            info[i] = entry[InfoOffset];
+            shndx[i] = _load<std::uint16_t>(entry, ShndxOffset);
+        }
+    }
+
+
+    bool decodeSymbolTable(const std::uint8_t* data, std::size_t count, ElfClass el_class,
+                           SymbolColumns& columns_out)
+    {
+        if (el_class != ElfClass::class64 && el_class != ElfClass::class32) return false;
+
+        columns_out.value.resize(count);
+        columns_out.size.resize(count);
+        columns_out.name.resize(count);
+        columns_out.info.resize(count);
+        columns_out.shndx.resize(count);
+
+        if (el_class == ElfClass::class64) {
+            _decode_symbol_columns<SymbolTableEntry64, 0, 8, 16, 4, 6>(data, count, columns_out);
+        }
+        else {
+            _decode_symbol_columns<SymbolTableEntry32, 0, 4, 8, 12, 14>(data, count, columns_out);
+        }
+        return true;
+    }
+
+
+    bool decodeSymbolTable(const ElfFile& file, const SectionHeader& symtab, SymbolColumns& columns_out)
+    {
+        std::size_t entrySize = file.el_class() == ElfClass::class64 ?
+            sizeof(SymbolTableEntry64) : sizeof(SymbolTableEntry32);
+
+        SectionView contents = file.section(symtab);
+        return decodeSymbolTable(contents.data, contents.size / entrySize, file.el_class(), columns_out);
+    }
+
+
+    bool SymbolAddressIndex::build(const ElfFile& file)
+    {
+        SectionHeader symtab;
+        if (file.sectionHeader(".symtab", symtab) && symtab.sh_type == SectionType::SymTab) {
+            return build(file, symtab);
+        }
+        if (file.sectionHeader(".dynsym", symtab) && symtab.sh_type == SectionType::DynSym) {
+            return build(file, symtab);
+        }
+        clear();
+        return false;
+    }
+
+
+    bool SymbolAddressIndex::build(const ElfFile& file, const SectionHeader& symtab)
+    {
+        clear();
+
+        // Symbol names live in the string table linked from the symbol table
+        SectionView names = file.section(symtab.sh_link);
+        if (names.size != 0 && names.data[names.size - 1] == '\0') {
+            strtab = names;
+        }
+
+        struct Entry
+        {
+            std::uint64_t start;
+            std::uint64_t size;
+            std::uint32_t name;
+            std::uint8_t preference;
+        };
+        std::vector<Entry> entries;
+
+        SymbolColumns symbols;
+        if (!decodeSymbolTable(file, symtab, symbols)) return false;
+
+        for (std::size_t i = 0; i < symbols.count(); i++)
+        {
+            if (symbols.type(i) != SymbolType::Function &&
+                symbols.type(i) != SymbolType::Object) continue;
+            if (symbols.shndx[i] == SHN_UNDEF) continue;
+
+            // Prefer global, then weak, then local definitions at the same address
+            std::uint8_t preference = symbols.binding(i) == SymbolBinding::Global ? 0 :
+                symbols.binding(i) == SymbolBinding::Weak ? 1 : 2;
+
+            entries.push_back(Entry{ symbols.value[i], symbols.size[i], symbols.name[i], preference });
+        }
+
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b)
+        {
+            if (a.start != b.start) return a.start < b.start;
+            if (a.size != b.size) return a.size > b.size;
+            return a.preference < b.preference;
+        });
+
+        // Keep one symbol per range (aliases share the same range). Smaller symbols at the
+        // same start follow the larger ones containing them, so are found first.
+        entries.erase(std::unique(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return a.start == b.start && a.size == b.size;
+        }), entries.end());
+
+        if (entries.size() >= static_cast<std::uint32_t>(-1)) return false;
+
+        starts.reserve(entries.size());
+        sizes.reserve(entries.size());
+        nameOffsets.reserve(entries.size());
+        containers.reserve(entries.size());
+
+        // Symbols whose ranges have not yet ended, innermost last
+        std::vector<std::uint32_t> open;
+        for (const Entry& entry : entries)
+        {
+            while (!open.empty() && starts[open.back()] + sizes[open.back()] <= entry.start) open.pop_back();
+            containers.push_back(open.empty() ? noContainer : open.back());
+            open.push_back(static_cast<std::uint32_t>(starts.size()));
+
+            starts.push_back(entry.start);
+            sizes.push_back(entry.size);
+            nameOffsets.push_back(entry.name);
+        }
+
+        // Lay out search keys in Eytzinger order (index 0 unused)
+        searchKeys.resize(starts.size() + 1);
+        searchRanks.resize(starts.size() + 1);
+        layout(0, 1);
+        return true;
+    }
+
+
+    std::size_t SymbolAddressIndex::layout(std::size_t rank, std::size_t node) noexcept
+    {
+        // In-order traversal of the implicit tree assigns sorted ranks to nodes
+        if (node < searchKeys.size())
+        {
+            rank = layout(rank, 2 * node);
+            searchKeys[node] = starts[rank];
+            searchRanks[node] = static_cast<std::uint32_t>(rank);
+            rank = layout(rank + 1, 2 * node + 1);
+        }
+        return rank;
+    }
+
+
+    void SymbolAddressIndex::clear() noexcept
+    {
+        starts.clear(); sizes.clear(); nameOffsets.clear(); containers.clear();
+        searchKeys.clear(); searchRanks.clear();
+        strtab = SectionView{};
+    }
+
+
+    bool SymbolAddressIndex::find(std::uint64_t address, std::size_t& index_out) const noexcept
+    {
+        const std::size_t count = starts.size();
+        if (count == 0) return false;
+
+        // Descend to the first key greater than the address
+        const std::uint64_t* keys = searchKeys.data();
+        std::size_t node = 1;
+        while (node <= count)
+        {
+            // Prefetch the cache line holding this node's descendants three levels down
+            if (node * 8 <= count) __builtin_prefetch(keys + node * 8);
+            node = 2 * node + (keys[node] <= address);
+        }
+        // Undo the trailing right turns to recover the last left turn
+        node >>= __builtin_ffsll(static_cast<long long>(~node));
+
+        // Symbol with the greatest start at or below the address
+        std::size_t upper = node == 0 ? count : searchRanks[node];
+        if (upper == 0) return false;
+
+        // Any other symbol containing the address also covers that symbol's start,
+        // so is one of its containers
+        for (std::uint32_t index = static_cast<std::uint32_t>(upper - 1); index != noContainer; index = containers[index])
+        {
+            auto offset = address - starts[index];
+            if (offset < sizes[index] || (sizes[index] == 0 && offset == 0))
+            {
+                index_out = index;
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+    template<typename T>
+    static inline T _read_word(const std::uint8_t* data, std::size_t index) noexcept
+    {
+        T value; std::memcpy(&value, data + (sizeof(T) * index), sizeof(T));
+        return value;
+    }
+
+
+    bool SymbolHashTable::build(const ElfFile& file)
+    {
+        std::size_t index;
+        if (file.sectionIndex(".dynsym", index)) return build(file, index);
+        if (file.sectionIndex(".symtab", index)) return build(file, index);
+
+        *this = SymbolHashTable{};
+        return false;
+    }
+
+
+    bool SymbolHashTable::build(const ElfFile& file, std::size_t symtabIndex)
+    {
+        *this = SymbolHashTable{};
+
+        SectionHeader symtab;
+        if (!file.sectionHeader(symtabIndex, symtab)) return false;
+        if (symtab.sh_type != SectionType::SymTab && symtab.sh_type != SectionType::DynSym) return false;
+
+        std::size_t entrySize = file.el_class() == ElfClass::class64 ?
+            sizeof(SymbolTableEntry64) : sizeof(SymbolTableEntry32);
+
+        this->file = &file;
+        this->symtab = symtab;
+        symbols = file.section(symtab);
+        symbolCount = symbols.size / entrySize;
+
+        SectionView names = file.section(symtab.sh_link);
+        if (names.size != 0 && names.data[names.size - 1] == '\0') {
+            strtab = names;
+        }
+
+        // Find hash sections attached to this symbol table
+        for (const SectionHeader& section : file.sectionHeaders())
+        {
+            if (section.sh_link != symtabIndex) continue;
+
+            if (section.sh_type == SectionType::GnuHash && !hasGnuHash()) {
+                readGnuHash(file.section(section));
+            }
+            else if (section.sh_type == SectionType::Hash && !hasSysvHash()) {
+                readSysvHash(file.section(section));
+            }
+        }
+        return true;
+    }
+
+
+    bool SymbolHashTable::readGnuHash(SectionView section) noexcept
+    {
+        if (section.size < 16) return false;
+
+        auto bucketCount = _read_word<std::uint32_t>(section.data, 0);
+        auto symbolOffset = _read_word<std::uint32_t>(section.data, 1);
+        auto bloomSize = _read_word<std::uint32_t>(section.data, 2);
+        auto bloomShift = _read_word<std::uint32_t>(section.data, 3);
+
+        // Bloom filter words are the size of an address
+        std::size_t bloomWordSize = file->el_class() == ElfClass::class64 ? 8 : 4;
+        std::uint64_t headerSize = 16 + (std::uint64_t(bloomSize) * bloomWordSize) + (std::uint64_t(bucketCount) * 4);
+
+        if (bucketCount == 0 || bloomSize == 0 || headerSize > section.size) return false;
+        // Hashes are 32 bits, so larger shifts are malformed
+        if (bloomShift >= 32) return false;
+        if (symbolOffset > symbolCount) return false;
+
+        gnuBloom = section.data + 16;
+        gnuBuckets = gnuBloom + (std::size_t(bloomSize) * bloomWordSize);
+        gnuBucketCount = bucketCount;
+        gnuSymbolOffset = symbolOffset;
+        gnuBloomSize = bloomSize;
+        gnuBloomShift = bloomShift;
+
+        // The chain array holds one word per hashed symbol
+        gnuChains = gnuBuckets + (std::size_t(bucketCount) * 4);
+        if ((section.size - headerSize) / 4 < symbolCount - symbolOffset)
+        {
+            gnuBuckets = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+
+    bool SymbolHashTable::readSysvHash(SectionView section) noexcept
+    {
+        if (section.size < 8) return false;
+
+        auto bucketCount = _read_word<std::uint32_t>(section.data, 0);
+        auto chainCount = _read_word<std::uint32_t>(section.data, 1);
+
+        if (bucketCount == 0 || (section.size / 4) - 2 < std::uint64_t(bucketCount) + chainCount) return false;
+
+        sysvBuckets = section.data + 8;
+        sysvChains = sysvBuckets + (std::size_t(bucketCount) * 4);
+        sysvBucketCount = bucketCount;
+        sysvChainCount = chainCount;
+        return true;
+    }
+
+
+    bool SymbolHashTable::symbolAt(std::size_t index, SymbolTableEntry& symbol_out) const noexcept
+    {
+        if (index >= symbolCount) return false;
+
+        std::size_t entrySize = file->el_class() == ElfClass::class64 ?
+            sizeof(SymbolTableEntry64) : sizeof(SymbolTableEntry32);
+        return decodeSymbolTableEntry(symbols.data + (index * entrySize), entrySize,
+                                      file->el_class(), symbol_out);
+    }
+
+
+    bool SymbolHashTable::matches(std::uint32_t nameOffset, std::uint16_t shndx,
+                                  std::string_view name) const noexcept
+    {
+        if (shndx == SHN_UNDEF || nameOffset >= strtab.size) return false;
+
+        // Name must match and be followed by its terminator within the table
+        const char* symbolName = reinterpret_cast<const char*>(strtab.data + nameOffset);
+        if (strtab.size - nameOffset <= name.size()) return false;
+        return std::memcmp(symbolName, name.data(), name.size()) == 0 && symbolName[name.size()] == '\0';
+    }
+
+
+    bool SymbolHashTable::lookupSymbol(std::string_view name, SymbolTableEntry& symbol_out) const noexcept
+    {
+        if (file == nullptr) return false;
+
+        if (hasGnuHash())
+        {
+            const std::uint32_t hash = gnuHash(name);
+            const std::uint32_t bits = file->el_class() == ElfClass::class64 ? 64 : 32;
+
+            // Reject via the bloom filter, which tests two bits per name
+            std::uint64_t word = bits == 64 ?
+                _read_word<std::uint64_t>(gnuBloom, (hash / bits) % gnuBloomSize) :
+                _read_word<std::uint32_t>(gnuBloom, (hash / bits) % gnuBloomSize);
+            std::uint64_t mask = (std::uint64_t(1) << (hash % bits)) |
+                                 (std::uint64_t(1) << ((hash >> gnuBloomShift) % bits));
+            if ((word & mask) != mask) return false;
+
+            std::uint32_t index = _read_word<std::uint32_t>(gnuBuckets, hash % gnuBucketCount);
+            if (index < gnuSymbolOffset) return false;
+
+            // Walk the chain; the low bit of each chain hash marks the chain's end
+            for (; index < symbolCount; index++)
+            {
+                std::uint32_t chainHash = _read_word<std::uint32_t>(gnuChains, index - gnuSymbolOffset);
+
+                if ((chainHash | 1) == (hash | 1) && symbolAt(index, symbol_out) && matches(symbol_out.st_name, symbol_out.st_shndx, name)) {
+                    return true;
+                }
+                if (chainHash & 1) break;
+            }
+            return false;
+        }
+
+        if (hasSysvHash())
+        {
+            std::uint32_t index = _read_word<std::uint32_t>(sysvBuckets, sysvHash(name) % sysvBucketCount);
+
+            // Index 0 (STN_UNDEF) terminates the chain; bound steps to reject cyclic chains
+            for (std::uint32_t steps = 0; index != 0 && index < sysvChainCount && steps < sysvChainCount; steps++)
+            {
+                if (symbolAt(index, symbol_out) && matches(symbol_out.st_name, symbol_out.st_shndx, name)) return true;
+                index = _read_word<std::uint32_t>(sysvChains, index);
+            }
+            return false;
+        }
+
+        // No hash section - scan the table in its native layout, decoding only the match
+        return dispatch_class(file->el_class(), [&](auto el_class)
+        {
+            std::size_t index = 0;
+            for (const auto& symbol : file->symbols<el_class>(symtab))
+            {
+                if (matches(symbol.st_name, symbol.st_shndx, name)) {
+                    return symbolAt(index, symbol_out);
+                }
+                index++;
+            }
+            return false;
+        });
+    }
+}
@@ -0,0 +1,191 @@
+/* symbols.hpp - (c) James S Renwick 2020 */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+#include "elf.hpp"
+#include "file.hpp"
+
+
+namespace elf
+{
+    /* A symbol table decoded into one contiguous array per field. */
+    struct SymbolColumns
+    {
+        std::vector<std::uint64_t> value{};
+        std::vector<std::uint64_t> size{};
+        std::vector<std::uint32_t> name{};  // Offset into the linked string table
+        std::vector<std::uint8_t>  info{};  // Type (low nibble) and binding (high nibble)
+        std::vector<std::uint16_t> shndx{};
+
+    public:
+        inline std::size_t count() const noexcept {
+            return value.size();
+        }
+        inline SymbolType type(std::size_t index) const noexcept {
+            return static_cast<SymbolType>(info[index] & 0xF);
+        }
+        inline SymbolBinding binding(std::size_t index) const noexcept {
+            return static_cast<SymbolBinding>(info[index] >> 4);
+        }
+    };
+
+    /* Decodes 'count' symbol table entries into columns in a single pass.
+       Equivalent to decoding each entry with decodeSymbolTableEntry. */
+    bool decodeSymbolTable(const std::uint8_t* data, std::size_t count, ElfClass el_class,
+                           SymbolColumns& columns_out);
+
+    /* Decodes the given SHT_SYMTAB/SHT_DYNSYM section of the file into columns. */
+    bool decodeSymbolTable(const ElfFile& file, const SectionHeader& symtab, SymbolColumns& columns_out);
+
+
+
+    /* Address-ordered index over the function and object symbols of a symbol table,
+       answering "which symbol contains address X". Symbols are held as parallel arrays
+       sorted by start address; lookups search a copy of the start addresses in Eytzinger
+       (breadth-first) order, so the first levels of the search share a few cache lines.
+       Symbols may be nested (e.g. local labels within a function), in which case the
+       innermost symbol containing the address is found. */
+    class SymbolAddressIndex
+    {
+    private:
+        static constexpr std::uint32_t noContainer = static_cast<std::uint32_t>(-1);
+
+        // Sorted by start address
+        std::vector<std::uint64_t> starts{};
+        std::vector<std::uint64_t> sizes{};
+        std::vector<std::uint32_t> nameOffsets{};
+        // Position of the closest preceding symbol whose range covers the symbol's start,
+        // or noContainer
+        std::vector<std::uint32_t> containers{};
+
+        // Start addresses in Eytzinger order (1-based) and their sorted positions
+        std::vector<std::uint64_t> searchKeys{};
+        std::vector<std::uint32_t> searchRanks{};
+
+        SectionView strtab{};
+
+    public:
+        SymbolAddressIndex() = default;
+
+        /* Builds the index from .symtab if present, otherwise from .dynsym.
+           Returns false if the file has neither. */
+        bool build(const ElfFile& file);
+
+        /* Builds the index from the given symbol table section. Only defined
+           STT_FUNC and STT_OBJECT symbols are indexed. */
+        bool build(const ElfFile& file, const SectionHeader& symtab);
+
+        void clear() noexcept;
+
+        /* Finds the symbol whose range [start, start + size) contains the given address.
+           Zero-sized symbols contain only their start address. */
+        bool find(std::uint64_t address, std::size_t& index_out) const noexcept;
+
+    public:
+        inline std::size_t size() const noexcept {
+            return starts.size();
+        }
+        inline std::uint64_t start(std::size_t index) const noexcept {
+            return starts[index];
+        }
+        inline std::uint64_t size(std::size_t index) const noexcept {
+            return sizes[index];
+        }
+        inline std::uint32_t nameOffset(std::size_t index) const noexcept {
+            return nameOffsets[index];
+        }
+        /* Gets the symbol's name from the associated string table, or nullptr. */
+        inline const char* name(std::size_t index) const noexcept
+        {
+            auto offset = nameOffsets[index];
+            if (offset >= strtab.size) return nullptr;
+            return reinterpret_cast<const char*>(strtab.data + offset);
+        }
+
+    private:
+        std::size_t layout(std::size_t rank, std::size_t node) noexcept;
+    };
+
+
+    /* Symbol-by-name lookup over the dynamic symbol table using the .gnu.hash or .hash
+       section, in the same way as the dynamic loader. Where the file has neither, lookups
+       fall back to a linear scan of the symbol table. */
+    class SymbolHashTable
+    {
+    private:
+        const ElfFile* file{};
+        SectionHeader symtab{};
+        SectionView symbols{};
+        SectionView strtab{};
+        std::size_t symbolCount{};
+
+        // .gnu.hash
+        const std::uint8_t* gnuBloom{};
+        const std::uint8_t* gnuBuckets{};
+        const std::uint8_t* gnuChains{};
+        std::uint32_t gnuBucketCount{};
+        std::uint32_t gnuSymbolOffset{};
+        std::uint32_t gnuBloomSize{};
+        std::uint32_t gnuBloomShift{};
+
+        // .hash
+        const std::uint8_t* sysvBuckets{};
+        const std::uint8_t* sysvChains{};
+        std::uint32_t sysvBucketCount{};
+        std::uint32_t sysvChainCount{};
+
+    public:
+        /* GNU hash function (Bernstein). */
+        static inline std::uint32_t gnuHash(std::string_view name) noexcept
+        {
+            std::uint32_t h = 5381;
+            for (unsigned char c : name) h = (h << 5) + h + c;
+            return h;
+        }
+
+        /* System V ABI hash function. */
+        static inline std::uint32_t sysvHash(std::string_view name) noexcept
+        {
+            std::uint32_t h = 0;
+            for (unsigned char c : name)
+            {
+                h = (h << 4) + c;
+                std::uint32_t g = h & 0xF0000000;
+                if (g != 0) h ^= g >> 24;
+                h &= ~g;
+            }
+            return h;
+        }
+
+    public:
+        SymbolHashTable() = default;
+
+        /* Prepares lookups against .dynsym, or .symtab if the file has no dynamic
+           symbol table. Returns false if the file has neither. */
+        bool build(const ElfFile& file);
+
+        /* Prepares lookups against the given symbol table, using any hash section
+           linked to it. */
+        bool build(const ElfFile& file, std::size_t symtabIndex);
+
+        inline bool hasGnuHash() const noexcept {
+            return gnuBuckets != nullptr;
+        }
+        inline bool hasSysvHash() const noexcept {
+            return sysvBuckets != nullptr;
+        }
+
+        /* Finds the defined symbol with the given name. */
+        bool lookupSymbol(std::string_view name, SymbolTableEntry& symbol_out) const noexcept;
+
+    private:
+        bool readGnuHash(SectionView section) noexcept;
+        bool readSysvHash(SectionView section) noexcept;
+
+        bool symbolAt(std::size_t index, SymbolTableEntry& symbol_out) const noexcept;
+        bool matches(std::uint32_t nameOffset, std::uint16_t shndx, std::string_view name) const noexcept;
+    };
+}
@@ -0,0 +1,374 @@
+/* indexer.cpp - (c) James S Renwick 2020 */
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <unistd.h>
+#include <memory>
+#include "dwarf/loader.hpp"
+#include "tests/test.hpp"
+
+using namespace dwarf;
+
+// 400 levels of nested types, giving DIEs nested deeper than a recursive parser would handle
+// comfortably. Each type is used by a member so that its debug information is emitted.
+// This file is compiled with debug information and reads its own.
+#define DEEP_CAT(a, b) DEEP_CAT_(a, b)
+#define DEEP_CAT_(a, b) a##b
+#define DEEP1(x) struct DEEP_CAT(Deep, __COUNTER__) { int member; x } inner;
+#define DEEP2(x) DEEP1(DEEP1(x))
+#define DEEP4(x) DEEP2(DEEP2(x))
+#define DEEP8(x) DEEP4(DEEP4(x))
+#define DEEP16(x) DEEP8(DEEP8(x))
+#define DEEP32(x) DEEP16(DEEP16(x))
+#define DEEP64(x) DEEP32(DEEP32(x))
+#define DEEP128(x) DEEP64(DEEP64(x))
+#define DEEP256(x) DEEP128(DEEP128(x))
+
+static constexpr std::size_t deepLevels = 400;
+struct DeepRoot { int member; DEEP256(DEEP128(DEEP16())) };
+DeepRoot deepRoot;
+
+
+// The sections borrow the file's mapping, so the file must outlive the context
+static bool loadContext(const char* path, elf::ElfFile& file, std::unique_ptr<DwarfContext>& context_out)
+{
+    if (!file.open(path)) return false;
+
+    std::vector<DwarfSection> sections;
+    if (loadSections(file, sections) == 0) return false;
+
+    context_out.reset(new DwarfContext(std::move(sections), DwarfWidth::Bits32));
+    return true;
+}
+
+template<typename T>
+static bool equal(const Column<T>& a, const Column<T>& b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+static bool equal(const DieColumns& a, const DieColumns& b)
+{
+    return equal(a.tags, b.tags) && equal(a.nameSources, b.nameSources) && equal(a.parents, b.parents) &&
+        equal(a.names, b.names) && equal(a.offsets, b.offsets) && equal(a.nextSiblings, b.nextSiblings) &&
+        equal(a.subtreeEnds, b.subtreeEnds) && a.droppedNames == b.droppedNames;
+}
+
+
+// Indexing in slices of any size gives the same index as a single pass
+static void testSlicedIndexing(const char* path, const DwarfContext& reference)
+{
+    struct Budget { std::size_t bytes, dies; };
+    const Budget budgets[] = { { 1, 0 }, { 0, 1 }, { 4096, 0 }, { 0, 64 }, { 100, 7 } };
+
+    for (auto& budget : budgets)
+    {
+        elf::ElfFile file;
+        std::unique_ptr<DwarfContext> context;
+        CHECK(loadContext(path, file, context));
+        if (!context) return;
+
+        auto& units = context->compilationUnits();
+        CHECK(units.size() == reference.compilationUnits().size());
+
+        for (std::size_t i = 0; i < units.size(); i++)
+        {
+            UnitIndexer indexer(*context, units[i]);
+            std::size_t calls = 0;
+            while (!indexer.finished() && indexer.resume(budget.bytes, budget.dies) == 0) calls++;
+
+            CHECK(indexer.finished());
+            CHECK(calls >= 1);
+            CHECK(equal(units[i].entries, reference.compilationUnits()[i].entries));
+        }
+    }
+}
+
+// The nested types are indexed with their full depth
+static void testDeepNesting(const DwarfContext& context)
+{
+    // Parents precede their children, so each depth is known before it is needed
+    std::size_t maxDepth = 0;
+    for (auto& unit : context.compilationUnits())
+    {
+        auto& parents = unit.entries.parents;
+        std::vector<std::size_t> depths(parents.size());
+        for (std::size_t i = 0; i < parents.size(); i++)
+        {
+            auto parent = parents[i];
+            depths[i] = parent == DieColumns::noParent ? 0 : depths[parent] + 1;
+            maxDepth = std::max(maxDepth, depths[i]);
+        }
+    }
+    // Each level sits below the unit DIE and the root type
+    CHECK(maxDepth >= deepLevels + 1);
+
+    CHECK(context.lookupByName("DeepRoot").size() >= 1);
+}
+
+
+// Counts the threads of this process
+static std::size_t threadCount()
+{
+    std::size_t count = 0;
+    DIR* tasks = ::opendir("/proc/self/task");
+    if (tasks == nullptr) return 0;
+    while (auto* task = ::readdir(tasks)) {
+        if (task->d_name[0] != '.') count++;
+    }
+    ::closedir(tasks);
+    return count;
+}
+
+// Repeated builds reuse the threads the context started for the first
+static void testWorkerReuse(const char* path)
+{
+    elf::ElfFile file;
+    std::unique_ptr<DwarfContext> context;
+    CHECK(loadContext(path, file, context));
+    if (!context || context->compilationUnits().size() < 4) return;
+
+    auto before = threadCount();
+    CHECK(context->buildIndexes(4) == 0);
+    auto started = threadCount();
+    CHECK(started == before + 3);
+
+    for (int i = 0; i < 3; i++) CHECK(context->buildIndexes(4) == 0);
+    CHECK(context->buildNameIndex(4) == 0);
+    CHECK(threadCount() == started);
+
+    context.reset();
+    CHECK(threadCount() == before);
+}
+
+
+// The layout of a cache file, as written by saveIndexCache
+static constexpr std::size_t cacheChecksumOffset = 24;
+static constexpr std::size_t cacheSectionsKeyOffset = 40;
+static constexpr std::size_t cacheHeaderSize = 152;
+static constexpr std::size_t cacheNameCountOffset = 120;
+static constexpr std::size_t cacheNamesOffsetOffset = 144;
+
+static std::uint64_t read64(const std::vector<std::uint8_t>& image, std::size_t offset)
+{
+    std::uint64_t value; std::memcpy(&value, image.data() + offset, sizeof(value));
+    return value;
+}
+template<typename T>
+static void write(std::vector<std::uint8_t>& image, std::size_t offset, T value) {
+    std::memcpy(image.data() + offset, &value, sizeof(value));
+}
+
+// Recomputes the checksum of a cache file, as in cache.cpp, so that corruption is only
+// caught by checking the arrays themselves
+static void rehash(std::vector<std::uint8_t>& image)
+{
+    constexpr std::uint64_t c1 = 0x87c37b91114253d5ull, c2 = 0x4cf5ad432745937full;
+    auto rotl = [](std::uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); };
+    auto mix = [&](std::uint64_t word) { return rotl(word * c1, 31) * c2; };
+
+    const std::uint8_t* data = image.data() + cacheHeaderSize;
+    std::size_t size = image.size() - cacheHeaderSize;
+
+    std::uint64_t hash = size * c1;
+    for (; size >= 8; data += 8, size -= 8)
+    {
+        std::uint64_t word; std::memcpy(&word, data, 8);
+        hash = rotl(hash ^ mix(word), 27) * 5 + 0x52dce729;
+    }
+    if (size != 0)
+    {
+        std::uint64_t word = 0; std::memcpy(&word, data, size);
+        hash ^= mix(word);
+    }
+    hash ^= hash >> 33; hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33; hash *= 0xc4ceb9fe1a85ec53ull;
+    write(image, cacheChecksumOffset, hash ^ (hash >> 33));
+}
+
+static bool writeFile(const std::string& path, const std::vector<std::uint8_t>& image)
+{
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) return false;
+    bool written = std::fwrite(image.data(), 1, image.size(), file) == image.size();
+    return std::fclose(file) == 0 && written;
+}
+
+static bool readFile(const std::string& path, std::vector<std::uint8_t>& image_out)
+{
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) return false;
+    std::uint8_t buffer[65536];
+    for (std::size_t count; (count = std::fread(buffer, 1, sizeof(buffer), file)) != 0; ) {
+        image_out.insert(image_out.end(), buffer, buffer + count);
+    }
+    std::fclose(file);
+    return !image_out.empty();
+}
+
+// Loads the given cache file into a fresh context, giving the context if accepted
+static bool loadCache(const char* path, const std::string& cachePath, const std::vector<std::uint8_t>& image,
+    elf::ElfFile& file, std::unique_ptr<DwarfContext>& context_out, bool verifyContents = false)
+{
+    if (!writeFile(cachePath, image) || !loadContext(path, file, context_out)) return false;
+    return context_out->loadIndexCache(cachePath.c_str(), nullptr, 0, verifyContents) == 0;
+}
+
+// Whether a fresh context accepts the given cache file
+static bool loadsCache(const char* path, const std::string& cachePath, const std::vector<std::uint8_t>& image,
+    bool verifyContents = false)
+{
+    elf::ElfFile file;
+    std::unique_ptr<DwarfContext> context;
+    return loadCache(path, cachePath, image, file, context, verifyContents);
+}
+
+// Whether the first unit of a context loaded from the given cache file is adopted from the
+// file (rather than parsed) and matches the reference
+static bool adoptsFirstUnit(const char* path, const std::string& cachePath, const std::vector<std::uint8_t>& image,
+    const DwarfContext& reference, bool& adopted_out)
+{
+    elf::ElfFile file;
+    std::unique_ptr<DwarfContext> context;
+    if (!loadCache(path, cachePath, image, file, context)) return false;
+
+    auto& unit = context->compilationUnits()[0];
+    if (context->indexUnit(unit) != 0) return false;
+
+    adopted_out = unit.entries.tags.isBorrowed();
+    return equal(unit.entries, reference.compilationUnits()[0].entries);
+}
+
+
+// Loading a cache reads only its header and layout. A unit whose cached columns hold
+// out-of-range positions is parsed instead; a corrupt name index finds nothing rather than
+// reading out of bounds.
+static void testCorruptCache(const char* path, const DwarfContext& reference)
+{
+    std::string cachePath = "/tmp/libdwarf-indexer-" + std::to_string(::getpid()) + ".cache";
+    std::vector<std::uint8_t> image;
+    CHECK(reference.saveIndexCache(cachePath.c_str(), nullptr, 0) == 0);
+    CHECK(readFile(cachePath, image));
+    if (image.size() < cacheHeaderSize) return;
+
+    // The first unit's record follows the header; its columns begin with tags and name sources
+    auto entryCount = read64(image, cacheHeaderSize + 16);
+    auto columnsOffset = read64(image, cacheHeaderSize + 24);
+    auto parentsOffset = columnsOffset + ((entryCount * sizeof(DIEType) + 7) & ~std::uint64_t(7)) +
+        ((entryCount * sizeof(NameSource) + 7) & ~std::uint64_t(7));
+    auto stride = (entryCount * sizeof(std::uint32_t) + 7) & ~std::uint64_t(7);
+    auto subtreeEndsOffset = parentsOffset + 4 * stride;
+    CHECK(entryCount > 1);
+
+    // An intact cache is used in place, without parsing any abbreviations
+    {
+        elf::ElfFile file;
+        std::unique_ptr<DwarfContext> context;
+        CHECK(loadCache(path, cachePath, image, file, context));
+        if (context)
+        {
+            CHECK(context->lookupByName("DeepRoot") == reference.lookupByName("DeepRoot"));
+            CHECK(context->entryCount() == reference.entryCount());
+            for (auto& unit : context->compilationUnits()) {
+                CHECK(unit.entries.tags.isBorrowed() && unit.abbreviations == nullptr);
+            }
+        }
+    }
+    CHECK(loadsCache(path, cachePath, image, true));
+
+    bool adopted = false;
+    CHECK(adoptsFirstUnit(path, cachePath, image, reference, adopted) && adopted);
+
+    // A parent after its child, a name in an unknown section and a subtree ending past the
+    // unit. The contents are only checked against the checksum on request.
+    auto parent = image, source = image, subtreeEnd = image;
+    write(parent, parentsOffset + sizeof(std::uint32_t), static_cast<std::uint32_t>(entryCount));
+    write(source, columnsOffset + ((entryCount * sizeof(DIEType) + 7) & ~std::uint64_t(7)), std::uint8_t(0xff));
+    write(subtreeEnd, subtreeEndsOffset, static_cast<std::uint32_t>(entryCount + 1));
+
+    for (auto* copy : { &parent, &source, &subtreeEnd })
+    {
+        CHECK(!loadsCache(path, cachePath, *copy, true));
+        rehash(*copy);
+        CHECK(adoptsFirstUnit(path, cachePath, *copy, reference, adopted) && !adopted);
+    }
+
+    // A name index id in a unit that does not exist. The ids follow the names and slots.
+    auto expected = reference.lookupByName("DeepRoot");
+    CHECK(read64(image, cacheNameCountOffset) != 0 && !expected.empty());
+    auto nameCount = read64(image, cacheNameCountOffset);
+    auto slotCount = read64(image, cacheNameCountOffset + 8);
+    auto idCount = read64(image, cacheNameCountOffset + 16);
+    auto slotsOffset = read64(image, cacheNamesOffsetOffset) + ((nameCount * 24 + 7) & ~std::uint64_t(7));
+    auto idsOffset = slotsOffset + ((slotCount * sizeof(std::uint32_t) + 7) & ~std::uint64_t(7));
+
+    auto copy = image;
+    for (std::uint64_t i = 0; i < idCount; i++)
+    {
+        if (!expected.empty() && read64(image, idsOffset + i * 8) == expected.back())
+        {
+            write(copy, idsOffset + i * 8, makeDieId(static_cast<std::uint32_t>(reference.compilationUnits().size()), 0));
+            expected.pop_back();
+            break;
+        }
+    }
+    {
+        elf::ElfFile file;
+        std::unique_ptr<DwarfContext> context;
+        CHECK(loadCache(path, cachePath, copy, file, context));
+        if (context)
+        {
+            // The corrupt id is dropped, or if it was the name's first, the name is not found
+            auto ids = context->lookupByName("DeepRoot");
+            CHECK(ids == expected || ids.empty());
+        }
+    }
+
+    // A hash table without an empty slot to end probing
+    copy = image;
+    for (std::uint64_t i = 0; i < slotCount; i++) write(copy, slotsOffset + i * sizeof(std::uint32_t), std::uint32_t(0));
+    {
+        elf::ElfFile file;
+        std::unique_ptr<DwarfContext> context;
+        CHECK(loadCache(path, cachePath, copy, file, context));
+        if (context) CHECK(context->lookupByName("no such name").empty());
+    }
+
+    // An id count whose sizes in bytes wrap around to 0
+    copy = image;
+    write(copy, cacheNameCountOffset + 16, std::uint64_t(1) << 63);
+    CHECK(!loadsCache(path, cachePath, copy));
+
+    // A cache of sections at other offsets
+    copy = image;
+    write(copy, cacheSectionsKeyOffset, read64(image, cacheSectionsKeyOffset) + 1);
+    CHECK(!loadsCache(path, cachePath, copy));
+
+    std::remove(cachePath.c_str());
+}
+
+
+int main()
+{
+    char path[4096];
+    auto length = ::readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (length <= 0) return 1;
+    path[length] = '\0';
+
+    elf::ElfFile file;
+    std::unique_ptr<DwarfContext> reference;
+    CHECK(loadContext(path, file, reference));
+    if (reference)
+    {
+        CHECK(reference->buildNameIndex() == 0);
+        testSlicedIndexing(path, *reference);
+        testDeepNesting(*reference);
+        testCorruptCache(path, *reference);
+        testWorkerReuse(path);
+    }
+
+    return test::report() || deepRoot.member != 0;
+}
@@ -0,0 +1,156 @@
+/* segments.cpp - (c) James S Renwick 2020 */
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+#include "elf/segments.hpp"
+#include "tests/test.hpp"
+
+using namespace elf;
+
+static constexpr std::uint32_t R = 1u << static_cast<std::uint32_t>(SegmentFlags::Readable);
+static constexpr std::uint32_t W = 1u << static_cast<std::uint32_t>(SegmentFlags::Writable);
+static constexpr std::uint32_t X = 1u << static_cast<std::uint32_t>(SegmentFlags::Executable);
+
+// Builds an ELF64 image holding only the given PT_LOAD segments
+static std::vector<std::uint8_t> makeImage(const std::vector<ProgramHeaderEntry64>& segments) {
+    return test::makeImage({}, segments);
+}
+
+static ProgramHeaderEntry64 load(std::uint32_t flags, std::uint64_t offset, std::uint64_t vaddr,
+    std::uint64_t size, std::uint64_t align)
+{
+    return ProgramHeaderEntry64{ SegmentType::Load, static_cast<SegmentFlags>(flags),
+        offset, vaddr, vaddr, size, size, align };
+}
+
+
+// Addresses and file offsets translate through page-aligned segments, with the writable
+// segment's bss having no file offset
+static void testTranslation()
+{
+    auto data = load(R | W, 0x3000, 0x403000, 0x0200, 0x1000);
+    data.p_memsz = 0x1000;
+    auto image = makeImage({
+        load(R,     0x0000, 0x400000, 0x0800, 0x1000),
+        load(R | X, 0x1000, 0x401000, 0x1800, 0x1000),
+        data });
+
+    ElfFile file;
+    SegmentMap map;
+    CHECK(file.load(image.data(), image.size()));
+    CHECK(map.build(file) && map.size() == 3);
+    CHECK(map.imageBase() == 0x400000);
+
+    std::uint64_t value;
+    CHECK(map.fileOffset(0x401234, value) && value == 0x1234);
+    CHECK(map.fileOffset(0x4031ff, value) && value == 0x31ff);
+    CHECK(!map.fileOffset(0x403200, value));
+    CHECK(!map.fileOffset(0x402800, value));
+    CHECK(map.virtualAddress(0x1234, value) && value == 0x401234);
+    CHECK(!map.virtualAddress(0x3200, value));
+
+    const std::uint64_t base = 0x7f0000000000;
+    std::int64_t bias;
+    CHECK(map.loadBias(base + 0x401000, 0x1000, bias) && bias == static_cast<std::int64_t>(base));
+}
+
+// R/RX/RW segments aligned to 2MiB but packed in the file, as produced by lld
+// or with -z max-page-size=0x200000
+static void testHugeAlignment()
+{
+    auto image = makeImage({
+        load(R,     0x0000, 0x200000, 0x0800, 0x200000),
+        load(R | X, 0x1000, 0x201000, 0x1800, 0x200000),
+        load(R | W, 0x3000, 0x403000, 0x0200, 0x200000) });
+
+    ElfFile file;
+    SegmentMap map;
+    CHECK(file.load(image.data(), image.size()));
+    CHECK(map.build(file) && map.size() == 3);
+
+    const std::uint64_t base = 0x7f0000000000;
+    std::int64_t bias;
+
+    CHECK(map.loadBias(base + 0x200000, 0x0000, bias) && bias == static_cast<std::int64_t>(base));
+    CHECK(map.loadBias(base + 0x201000, 0x1000, bias) && bias == static_cast<std::int64_t>(base));
+    CHECK(map.loadBias(base + 0x403000, 0x3000, bias) && bias == static_cast<std::int64_t>(base));
+    CHECK(!map.loadBias(base + 0x404000, 0x4000, bias));
+}
+
+// Segments sharing a page of the file, told apart by the mapping's permissions
+static void testSharedPage()
+{
+    auto image = makeImage({
+        load(R | X, 0x0000, 0x200000, 0x3800, 0x200000),
+        load(R | W, 0x3800, 0x403800, 0x0200, 0x200000) });
+
+    ElfFile file;
+    SegmentMap map;
+    CHECK(file.load(image.data(), image.size()));
+    CHECK(map.build(file));
+
+    const std::uint64_t base = 0x7f0000000000;
+    std::int64_t bias;
+
+    CHECK(map.loadBias(base + 0x203000, 0x3000, "r-xp", bias) && bias == static_cast<std::int64_t>(base));
+    CHECK(map.loadBias(base + 0x403000, 0x3000, "rw-p", bias) && bias == static_cast<std::int64_t>(base));
+}
+
+// This test's own mappings. The makefile links it with 2MiB segment alignment.
+static void testSelf()
+{
+    char path[4096];
+    auto length = ::readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (length <= 0) return;
+    path[length] = '\0';
+
+    // Read the mappings before mapping the file again below
+    struct Mapping { unsigned long start, offset; char permissions[8]; };
+    std::vector<Mapping> mappings;
+
+    FILE* maps = std::fopen("/proc/self/maps", "r");
+    if (maps == nullptr) return;
+
+    char line[4096 + 128];
+    while (std::fgets(line, sizeof(line), maps) != nullptr)
+    {
+        Mapping mapping;
+        unsigned long end;
+        char file[4096 + 1] = {};
+        if (std::sscanf(line, "%lx-%lx %7s %lx %*s %*s %4096s", &mapping.start, &end,
+            mapping.permissions, &mapping.offset, file) < 4) continue;
+        if (std::strcmp(file, path) == 0) mappings.push_back(mapping);
+    }
+    std::fclose(maps);
+
+    ElfFile file;
+    SegmentMap map;
+    CHECK(file.open(path));
+    CHECK(map.build(file));
+    CHECK(!mappings.empty());
+
+    // Every mapping of the file has the same bias, which places the file's first
+    // page at the image base
+    std::int64_t expected = 0;
+    for (auto& mapping : mappings)
+    {
+        std::int64_t bias;
+        CHECK(map.loadBias(mapping.start, mapping.offset, mapping.permissions, bias));
+        if (&mapping == &mappings.front()) expected = bias;
+        CHECK(bias == expected);
+
+        if (mapping.offset == 0) CHECK(mapping.start - map.imageBase() == static_cast<std::uint64_t>(expected));
+    }
+}
+
+
+int main()
+{
+    testTranslation();
+    testHugeAlignment();
+    testSharedPage();
+    testSelf();
+
+    return test::report();
+}
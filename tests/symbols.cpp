@@ -0,0 +1,175 @@
+/* symbols.cpp - (c) James S Renwick 2020 */
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "elf/symbols.hpp"
+#include "tests/test.hpp"
+
+using namespace elf;
+using test::Section;
+using test::makeImage;
+
+
+struct Symbol
+{
+    const char* name;
+    std::uint64_t value;
+    std::uint64_t size;
+    SymbolType type;
+};
+
+// Makes a symbol table (with the null symbol first) and its string table
+static void makeSymbols(const std::vector<Symbol>& symbols, Section& symtab_out, Section& strtab_out)
+{
+    symtab_out = Section{ SectionType::SymTab, 2, std::vector<std::uint8_t>(sizeof(SymbolTableEntry64)) };
+    strtab_out = Section{ SectionType::StrTab, 0, std::vector<std::uint8_t>(1) };
+
+    for (auto& symbol : symbols)
+    {
+        SymbolTableEntry64 entry{};
+        entry.st_name = static_cast<std::uint32_t>(strtab_out.data.size());
+        entry.st_info_type = symbol.type;
+        entry.st_info_binding = SymbolBinding::Global;
+        entry.st_shndx = 1;
+        entry.st_value = symbol.value;
+        entry.st_size = symbol.size;
+
+        auto* bytes = reinterpret_cast<const std::uint8_t*>(&entry);
+        symtab_out.data.insert(symtab_out.data.end(), bytes, bytes + sizeof(entry));
+        strtab_out.data.insert(strtab_out.data.end(), symbol.name, symbol.name + std::strlen(symbol.name) + 1);
+    }
+}
+
+static std::string findName(const SymbolAddressIndex& index, std::uint64_t address)
+{
+    std::size_t found;
+    return index.find(address, found) ? index.name(found) : "";
+}
+
+
+// Function and object symbols are found by any address within them
+static void testLookup()
+{
+    Section symtab, strtab;
+    makeSymbols({
+        { "first",  0x1000, 0x10, SymbolType::Function },
+        { "alias",  0x1000, 0x10, SymbolType::Function },
+        { "data",   0x2000, 0x8,  SymbolType::Object },
+        { "file",   0x3000, 0x10, SymbolType::File } }, symtab, strtab);
+
+    auto image = makeImage({ symtab, strtab });
+    ElfFile file;
+    SectionHeader header;
+    SymbolAddressIndex index;
+    CHECK(file.load(image.data(), image.size()));
+    CHECK(file.sectionHeader(1, header));
+    CHECK(index.build(file, header));
+
+    // Aliases collapse to one entry; other symbol types are not indexed
+    CHECK(index.size() == 2);
+
+    auto name = findName(index, 0x100f);
+    CHECK(name == "first" || name == "alias");
+    CHECK(findName(index, 0x1010) == "");
+    CHECK(findName(index, 0x2000) == "data");
+    CHECK(findName(index, 0x2007) == "data");
+    CHECK(findName(index, 0x2008) == "");
+    CHECK(findName(index, 0x3000) == "");
+    CHECK(findName(index, 0x0fff) == "");
+}
+
+// Zero-size and nested symbols must not hide the function around them
+static void testNestedSymbols()
+{
+    Section symtab, strtab;
+    makeSymbols({
+        { "outer",   0x1000, 0x100, SymbolType::Function },
+        { "label",   0x1010, 0,     SymbolType::Function },
+        { "inner",   0x1040, 0x20,  SymbolType::Function },
+        { "label2",  0x1048, 0,     SymbolType::Function },
+        { "after",   0x1200, 0x10,  SymbolType::Function },
+        { "overlap", 0x1208, 0x20,  SymbolType::Object } }, symtab, strtab);
+
+    auto image = makeImage({ symtab, strtab });
+    ElfFile file;
+    SectionHeader header;
+    SymbolAddressIndex index;
+    CHECK(file.load(image.data(), image.size()));
+    CHECK(file.sectionHeader(1, header));
+    CHECK(index.build(file, header));
+
+    CHECK(findName(index, 0x1000) == "outer");
+    CHECK(findName(index, 0x1010) == "label");
+    CHECK(findName(index, 0x1011) == "outer");
+    CHECK(findName(index, 0x1040) == "inner");
+    CHECK(findName(index, 0x1049) == "inner");
+    CHECK(findName(index, 0x1060) == "outer");
+    CHECK(findName(index, 0x10ff) == "outer");
+    CHECK(findName(index, 0x1100) == "");
+    CHECK(findName(index, 0x120f) == "overlap");
+    CHECK(findName(index, 0x1210) == "overlap");
+    CHECK(findName(index, 0x0fff) == "");
+}
+
+// A smaller symbol starting at the same address as its container is not dropped
+static void testSameStartSymbols()
+{
+    Section symtab, strtab;
+    makeSymbols({
+        { "outer",  0x1000, 0x100, SymbolType::Function },
+        { "alias",  0x1000, 0x100, SymbolType::Function },
+        { "inner",  0x1000, 0x10,  SymbolType::Object },
+        { "label",  0x1000, 0,     SymbolType::Function } }, symtab, strtab);
+
+    auto image = makeImage({ symtab, strtab });
+    ElfFile file;
+    SectionHeader header;
+    SymbolAddressIndex index;
+    CHECK(file.load(image.data(), image.size()));
+    CHECK(file.sectionHeader(1, header));
+    CHECK(index.build(file, header));
+
+    CHECK(index.size() == 3);
+    CHECK(findName(index, 0x1000) == "label");
+    CHECK(findName(index, 0x1008) == "inner");
+    CHECK(findName(index, 0x1010) == "outer");
+    CHECK(findName(index, 0x10ff) == "outer");
+}
+
+// A malformed .gnu.hash is ignored in favour of a linear scan
+static void testMalformedGnuHash()
+{
+    Section symtab, strtab;
+    makeSymbols({
+        { "first",  0x1000, 0x10, SymbolType::Function },
+        { "second", 0x1010, 0x10, SymbolType::Function } }, symtab, strtab);
+    symtab.type = SectionType::DynSym;
+
+    // One bucket, one bloom word, a bloom shift beyond the width of the hash
+    std::uint32_t words[] = { 1, 1, 1, 40, 0xFFFFFFFF, 0xFFFFFFFF, 1, 0, 1 };
+    Section gnuHash{ SectionType::GnuHash, 1, std::vector<std::uint8_t>(
+        reinterpret_cast<std::uint8_t*>(words), reinterpret_cast<std::uint8_t*>(words) + sizeof(words)) };
+
+    auto image = makeImage({ symtab, strtab, gnuHash });
+    ElfFile file;
+    SymbolHashTable table;
+    SymbolTableEntry symbol;
+    CHECK(file.load(image.data(), image.size()));
+    CHECK(table.build(file, 1));
+    CHECK(!table.hasGnuHash());
+
+    CHECK(table.lookupSymbol("second", symbol) && symbol.st_value == 0x1010);
+    CHECK(!table.lookupSymbol("third", symbol));
+}
+
+
+int main()
+{
+    testLookup();
+    testNestedSymbols();
+    testSameStartSymbols();
+    testMalformedGnuHash();
+
+    return test::report();
+}
@@ -0,0 +1,87 @@
+/* test.hpp - (c) James S Renwick 2020 */
+#pragma once
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "elf/elf.hpp"
+
+/* Number of failed checks; each test's main returns report(). */
+inline int failures = 0;
+
+/* Checks a condition, reporting and counting a failure without stopping the test. */
+#define CHECK(cond) do { if (!(cond)) { std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+namespace test
+{
+    struct Section
+    {
+        elf::SectionType type;
+        std::uint32_t link;
+        std::vector<std::uint8_t> data;
+    };
+
+    /* Builds an ELF64 image holding the given program headers and sections. Sections are
+       numbered from 1, following the null section, and their data is 8-byte aligned. */
+    inline std::vector<std::uint8_t> makeImage(const std::vector<Section>& sections,
+        const std::vector<elf::ProgramHeaderEntry64>& segments = {})
+    {
+        using namespace elf;
+
+        // The program headers follow the ELF header
+        std::vector<std::uint8_t> image(sizeof(Header64) + segments.size() * sizeof(ProgramHeaderEntry64));
+        if (!segments.empty()) {
+            std::memcpy(image.data() + sizeof(Header64), segments.data(), segments.size() * sizeof(ProgramHeaderEntry64));
+        }
+
+        std::vector<SectionHeader64> headers(sections.size() + 1);
+        for (std::size_t i = 0; i < sections.size(); i++)
+        {
+            image.resize((image.size() + 7) & ~std::size_t(7));
+
+            auto& header = headers[i + 1];
+            header = SectionHeader64{};
+            header.sh_type = sections[i].type;
+            header.sh_link = sections[i].link;
+            header.sh_offset = image.size();
+            header.sh_size = sections[i].data.size();
+            if (sections[i].type == SectionType::SymTab || sections[i].type == SectionType::DynSym) {
+                header.sh_entsize = sizeof(SymbolTableEntry64);
+            }
+            image.insert(image.end(), sections[i].data.begin(), sections[i].data.end());
+        }
+        image.resize((image.size() + 7) & ~std::size_t(7));
+
+        Header64 header{};
+        std::memcpy(header.e_ident, "\x7f" "ELF", 4);
+        header.e_ident[4] = static_cast<unsigned char>(ElfClass::class64);
+        header.e_ident[5] = 1; // Little-endian
+        header.e_ident[6] = 1;
+        header.e_type = 3;     // ET_DYN
+        header.e_version = 1;
+        header.e_ehsize = sizeof(Header64);
+        if (!segments.empty())
+        {
+            header.e_phoff = sizeof(Header64);
+            header.e_phentsize = sizeof(ProgramHeaderEntry64);
+            header.e_phnum = static_cast<std::uint16_t>(segments.size());
+        }
+        if (!sections.empty())
+        {
+            header.e_shoff = image.size();
+            header.e_shentsize = sizeof(SectionHeader64);
+            header.e_shnum = static_cast<std::uint16_t>(headers.size());
+
+            auto* begin = reinterpret_cast<const std::uint8_t*>(headers.data());
+            image.insert(image.end(), begin, begin + headers.size() * sizeof(SectionHeader64));
+        }
+        std::memcpy(image.data(), &header, sizeof(header));
+        return image;
+    }
+
+    /* Prints the number of failures, if any, and gives the test's exit status. */
+    inline int report()
+    {
+        if (failures != 0) std::printf("%d failure(s)\n", failures);
+        return failures != 0;
+    }
+}
@@ -0,0 +1,197 @@
+/* units.cpp - (c) James S Renwick 2020 */
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <sys/mman.h>
+#include "dwarf/dwarf.hpp"
+#include "tests/test.hpp"
+
+using namespace dwarf;
+
+
+// Abbreviation codes of the table at offset 0
+enum : std::uint8_t { UnitCode = 1, StructCode = 2, BaseCode = 3 };
+
+static const std::vector<std::uint8_t> abbreviations = {
+    UnitCode,   0x11, 1,                         0, 0, // DW_TAG_compile_unit, with children
+    StructCode, 0x13, 1, 0x01, 0x13, 0x03, 0x08, 0, 0, // DW_TAG_structure_type: DW_AT_sibling (ref4), DW_AT_name (string)
+    BaseCode,   0x24, 0, 0x03, 0x08,             0, 0, // DW_TAG_base_type: DW_AT_name (string)
+    0,
+    // A table with a duplicate code, at duplicateTable
+    UnitCode, 0x11, 1, 0, 0,
+    UnitCode, 0x11, 1, 0, 0,
+    0
+};
+static constexpr std::uint32_t duplicateTable = 22;
+
+struct Unit
+{
+    std::uint32_t abbrevOffset;
+    std::vector<std::uint8_t> dies;
+};
+
+// Size of a 32-bit DWARF 4 unit header
+static constexpr std::size_t headerSize = 11;
+
+// Lays out the given units as a 32-bit DWARF 4 .debug_info section
+static std::vector<std::uint8_t> makeInfo(const std::vector<Unit>& units)
+{
+    std::vector<std::uint8_t> info;
+    for (auto& unit : units)
+    {
+        std::uint32_t length = static_cast<std::uint32_t>(headerSize - 4 + unit.dies.size());
+        std::uint16_t version = 4;
+        std::uint8_t header[headerSize];
+        std::memcpy(header, &length, 4);
+        std::memcpy(header + 4, &version, 2);
+        std::memcpy(header + 6, &unit.abbrevOffset, 4);
+        header[10] = 8; // Address size
+
+        info.insert(info.end(), header, header + headerSize);
+        info.insert(info.end(), unit.dies.begin(), unit.dies.end());
+    }
+    return info;
+}
+
+// Creates a context borrowing the given sections, which must outlive it
+static std::unique_ptr<DwarfContext> makeContext(const std::vector<std::uint8_t>& info,
+    const std::vector<std::uint8_t>& abbrev = abbreviations)
+{
+    std::vector<DwarfSection> sections;
+    sections.emplace_back(SectionType::debug_info, info.data(), info.size());
+    sections.emplace_back(SectionType::debug_abbrev, abbrev.data(), abbrev.size());
+    return std::unique_ptr<DwarfContext>(new DwarfContext(std::move(sections), DwarfWidth::Bits32));
+}
+
+
+// Abbreviations are loaded as a unit is first indexed. Units whose table cannot be parsed
+// are left without one and fail to index, without affecting other units.
+static void testBadAbbreviations()
+{
+    const std::vector<std::uint8_t> dies = { UnitCode, BaseCode, 'i', 'n', 't', 0, 0 };
+    auto info = makeInfo({ { 0, dies }, { 0x1000, dies }, { duplicateTable, dies } });
+    auto context = makeContext(info);
+
+    auto& units = context->compilationUnits();
+    CHECK(units.size() == 3);
+    if (units.size() != 3) return;
+
+    CHECK(context->indexUnit(units[0]) == 0 && units[0].entries.size() == 2);
+    CHECK(units[0].abbreviations != nullptr);
+
+    for (std::size_t i = 1; i < 3; i++)
+    {
+        CHECK(context->indexUnit(units[i]) == -1 && units[i].entries.size() == 0);
+        CHECK(units[i].abbreviations == nullptr);
+    }
+}
+
+// Counting the DIEs of a context indexes its units first
+static void testEntryCount()
+{
+    const std::vector<std::uint8_t> dies = { UnitCode, BaseCode, 'i', 'n', 't', 0, 0 };
+    auto info = makeInfo({ { 0, dies }, { 0, dies }, { 0x1000, dies } });
+    auto context = makeContext(info);
+
+    CHECK(context->entryCount() == 4);
+}
+
+
+// Top-level traversal ignores a DW_AT_sibling that does not lead past the DIE's children
+static void testBadSiblings()
+{
+    // A struct at offset 12 holding a base type, followed by another base type. The struct's
+    // sibling is patched in at offset 13.
+    std::vector<std::uint8_t> dies = {
+        UnitCode,
+            StructCode, 0, 0, 0, 0, 'S', 0,
+                BaseCode, 'i', 'n', 't', 0,
+                0,
+            BaseCode, 'x', 0,
+            0 };
+
+    // Offsets relative to the unit: just past the struct (its first child), the struct
+    // itself, and past the end of the unit
+    for (std::uint32_t sibling : { 19u, 12u, 0x1000u })
+    {
+        std::memcpy(dies.data() + 2, &sibling, sizeof(sibling));
+        auto info = makeInfo({ { 0, dies } });
+        auto context = makeContext(info);
+        if (context->compilationUnits().size() != 1) { CHECK(false); return; }
+
+        std::vector<DieLocation> entries;
+        CHECK(context->unitEntries(context->compilationUnits()[0], TraversalMode::TopLevel, entries) == 0);
+        CHECK(entries.size() == 3);
+        if (entries.size() != 3) continue;
+
+        CHECK(entries[0].depth == 0 && entries[0].type == DIEType::CompileUnit);
+        CHECK(entries[1].depth == 1 && std::strcmp(entries[1].name, "S") == 0);
+        CHECK(entries[2].depth == 1 && std::strcmp(entries[2].name, "x") == 0);
+    }
+}
+
+
+// A unit ending within a DIE's children fails to index, in one pass or in slices
+static void testTruncatedUnit()
+{
+    const std::vector<std::uint8_t> dies = {
+        UnitCode,
+            StructCode, 0, 0, 0, 0, 'S', 0,
+                BaseCode, 'i', 'n', 't', 0 };
+    auto info = makeInfo({ { 0, dies }, { 0, dies } });
+    auto context = makeContext(info);
+    auto& units = context->compilationUnits();
+    if (units.size() != 2) { CHECK(false); return; }
+
+    CHECK(context->indexUnit(units[0]) == -1 && units[0].entries.size() == 0);
+
+    UnitIndexer indexer(*context, units[1]);
+    dwarf::error_t result = 0;
+    while (result == 0 && !indexer.finished()) result = indexer.resume(0, 1);
+    CHECK(result == -1);
+}
+
+
+// A DWARF64 unit too large for 32-bit offsets within the unit is not indexed
+static void testOversizedUnit()
+{
+    // A section holding a single unit of just over 4 GiB, mostly untouched zero pages
+    const std::uint64_t length = (std::uint64_t(1) << 32) + 16;
+    const std::size_t size = 12 + length;
+    void* mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mapping == MAP_FAILED) { std::printf("skipping testOversizedUnit: cannot map 4 GiB\n"); return; }
+    auto* info = static_cast<std::uint8_t*>(mapping);
+
+    std::uint16_t version = 4;
+    std::memset(info, 0xff, 4);
+    std::memcpy(info + 4, &length, 8);
+    std::memcpy(info + 12, &version, 2);
+    info[22] = 8; // Address size, following an 8-byte abbreviation offset of 0
+    const std::uint8_t dies[] = { UnitCode, BaseCode, 'i', 'n', 't', 0 };
+    std::memcpy(info + 23, dies, sizeof(dies));
+
+    {
+        std::vector<DwarfSection> sections;
+        sections.emplace_back(SectionType::debug_info, info, size);
+        sections.emplace_back(SectionType::debug_abbrev, abbreviations.data(), abbreviations.size());
+        DwarfContext context(std::move(sections), DwarfWidth::Bits64);
+
+        auto& units = context.compilationUnits();
+        CHECK(units.size() == 1);
+        if (units.size() == 1) CHECK(context.indexUnit(units[0]) == -1 && units[0].entries.size() == 0);
+    }
+    ::munmap(mapping, size);
+}
+
+
+int main()
+{
+    testBadAbbreviations();
+    testEntryCount();
+    testBadSiblings();
+    testTruncatedUnit();
+    testOversizedUnit();
+
+    return test::report();
+}